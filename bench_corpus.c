@@ -0,0 +1,229 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "llurl.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_RDTSC 1
+#include <x86intrin.h>
+#endif
+
+/* Corpus benchmark for http_parser_parse_url()
+ *
+ * Memory-maps a newline-separated URL corpus (see tools/gen_corpus.c) and
+ * parses every line, first in file order and then in a fixed shuffled
+ * order, so that neither the branch predictor nor the caches see one URL
+ * over and over. For each order it reports the best of several passes as
+ * ns/URL and MB/s, then times every URL on its own for p50/p99/p99.9
+ * latencies.
+ *
+ * Usage: bench_corpus corpus.txt [passes]
+ */
+
+#define DEFAULT_PASSES 5
+
+struct line {
+  const char *buf;
+  size_t len;
+};
+
+/* Get current time in seconds */
+static double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/* Per-URL timer: the TSC where there is one (a clock_gettime() call costs
+ * about as much as a parse), otherwise the monotonic clock in ns */
+static inline uint64_t ticks(void) {
+#if defined(HAVE_RDTSC)
+  _mm_lfence();
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Ticks per nanosecond, measured against the monotonic clock */
+static double ticks_per_ns(void) {
+#if defined(HAVE_RDTSC)
+  double start = get_time();
+  uint64_t t0 = ticks();
+  while (get_time() - start < 0.05) {
+  }
+  return (double)(ticks() - t0) / ((get_time() - start) * 1e9);
+#else
+  return 1.0;
+#endif
+}
+
+/* Cost of a ticks() pair with nothing between, the minimum of many */
+static uint64_t timer_overhead(void) {
+  uint64_t best = UINT64_MAX;
+  for (int k = 0; k < 10000; k++) {
+    uint64_t t0 = ticks();
+    uint64_t t1 = ticks();
+    if (t1 - t0 < best) {
+      best = t1 - t0;
+    }
+  }
+  return best;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* Split the mapped file into lines, dropping a trailing '\r' */
+static size_t split_lines(const char *data, size_t size, struct line **out) {
+  size_t n = 0, cap = 1024, pos = 0;
+  struct line *lines = malloc(cap * sizeof(*lines));
+
+  while (lines && pos < size) {
+    const char *nl = memchr(data + pos, '\n', size - pos);
+    size_t end = nl ? (size_t)(nl - data) : size;
+    size_t len = end - pos;
+    if (len > 0 && data[pos + len - 1] == '\r') {
+      len--;
+    }
+    if (n == cap) {
+      struct line *grown = realloc(lines, 2 * cap * sizeof(*lines));
+      if (!grown) {
+        free(lines);
+        return 0;
+      }
+      lines = grown;
+      cap *= 2;
+    }
+    lines[n].buf = data + pos;
+    lines[n].len = len;
+    n++;
+    pos = end + 1;
+  }
+  *out = lines;
+  return lines ? n : 0;
+}
+
+/* Fisher-Yates with a fixed xorshift seed, so runs are comparable */
+static void shuffle(struct line *lines, size_t n) {
+  uint64_t x = 0x9e3779b97f4a7c15ULL;
+  for (size_t k = n; k > 1; k--) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    size_t j = (size_t)(x % k);
+    struct line t = lines[k - 1];
+    lines[k - 1] = lines[j];
+    lines[j] = t;
+  }
+}
+
+/* Throughput and latency of one order of the corpus */
+static void run_order(const char *name, const struct line *lines, size_t n, size_t bytes,
+                      int passes, uint64_t *lat, double tpn, uint64_t overhead) {
+  double best = 0;
+  size_t failed = 0, sink = 0;
+
+  for (int p = 0; p < passes; p++) {
+    double start = get_time();
+    failed = 0;
+    for (size_t k = 0; k < n; k++) {
+      struct http_parser_url u;
+      http_parser_url_init(&u);
+      failed += http_parser_parse_url(lines[k].buf, lines[k].len, 0, &u) != 0;
+      sink += u.field_set;
+    }
+    double elapsed = get_time() - start;
+    if (p == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+
+  /* Latency pass: each parse timed on its own */
+  for (size_t k = 0; k < n; k++) {
+    struct http_parser_url u;
+    http_parser_url_init(&u);
+    uint64_t t0 = ticks();
+    http_parser_parse_url(lines[k].buf, lines[k].len, 0, &u);
+    uint64_t t1 = ticks();
+    sink += u.field_set;
+    lat[k] = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+  }
+  qsort(lat, n, sizeof(*lat), cmp_u64);
+
+  printf("%-10s %9.1f %9.1f %10.0f %9.1f %9.1f %9.1f\n", name, best / n * 1e9,
+         bytes / best / 1e6, n / best, lat[n / 2] / tpn, lat[n * 99 / 100] / tpn,
+         lat[n * 999 / 1000] / tpn);
+  printf("           (%zu failed to parse, checksum %zu)\n", failed, sink);
+}
+
+int main(int argc, char **argv) {
+  int passes = argc > 2 && atoi(argv[2]) > 0 ? atoi(argv[2]) : DEFAULT_PASSES;
+  struct line *lines = NULL;
+  struct stat st;
+  const char *data;
+  uint64_t *lat;
+  size_t n, bytes = 0;
+  double tpn;
+  uint64_t overhead;
+  int fd;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s corpus.txt [passes]\n", argv[0]);
+    return 2;
+  }
+  fd = open(argv[1], O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  if (st.st_size == 0) {
+    fprintf(stderr, "%s: empty corpus\n", argv[1]);
+    return 1;
+  }
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+
+  n = split_lines(data, (size_t)st.st_size, &lines);
+  lat = malloc((n ? n : 1) * sizeof(*lat));
+  if (n == 0 || !lat) {
+    fprintf(stderr, "%s: no URLs or out of memory\n", argv[1]);
+    return 1;
+  }
+  for (size_t k = 0; k < n; k++) {
+    bytes += lines[k].len;
+  }
+  tpn = ticks_per_ns();
+  overhead = timer_overhead();
+
+  printf("=====================================\n");
+  printf("  llurl Corpus Benchmark\n");
+  printf("=====================================\n\n");
+  printf("Corpus: %s, %zu URLs, %.1f MB, mean %.1f bytes\n", argv[1], n, bytes / 1e6,
+         (double)bytes / n);
+  printf("Best of %d passes; latencies in ns, timer overhead (%.1f ns) removed\n\n",
+         passes, overhead / tpn);
+  printf("Order        ns/URL      MB/s     URLs/s       p50       p99     p99.9\n");
+
+  run_order("file", lines, n, bytes, passes, lat, tpn, overhead);
+  shuffle(lines, n);
+  run_order("shuffled", lines, n, bytes, passes, lat, tpn, overhead);
+
+  free(lat);
+  free(lines);
+  munmap((void *)data, (size_t)st.st_size);
+  close(fd);
+  return 0;
+}
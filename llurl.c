@@ -24,6 +24,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+/* The batch scan kernels have SSE4.2 and AVX2 variants on x86 with GCC or
+ * Clang; the variant is chosen at load time from cpuid, so the library does
+ * not need to be built with -march. Other targets use the scalar kernel. */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LLURL_HAVE_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
 /* ============================================================================
  * CONSTANTS AND TYPE DEFINITIONS
  * ============================================================================ */
@@ -45,155 +53,31 @@ enum state {
   s_num_states
 };
 
-/* Character classes for DFA table */
-enum char_class {
-  cc_invalid = 0,     /* Invalid characters */
-  cc_alpha,           /* a-z, A-Z */
-  cc_digit,           /* 0-9 */
-  cc_slash,           /* / */
-  cc_colon,           /* : */
-  cc_question,        /* ? */
-  cc_hash,            /* # */
-  cc_at,              /* @ */
-  cc_dot,             /* . */
-  cc_dash,            /* - */
-  cc_plus,            /* + */
-  cc_percent,         /* % */
-  cc_ampersand,       /* & */
-  cc_equals,          /* = */
-  cc_semicolon,       /* ; */
-  cc_dollar,          /* $ */
-  cc_exclamation,     /* ! */
-  cc_asterisk,        /* * */
-  cc_comma,           /* , */
-  cc_lparen,          /* ( */
-  cc_rparen,          /* ) */
-  cc_apostrophe,      /* ' */
-  cc_underscore,      /* _ */
-  cc_tilde,           /* ~ */
-  cc_lbracket,        /* [ */
-  cc_rbracket,        /* ] */
-  cc_pipe,            /* | */
-  cc_lbrace,          /* { */
-  cc_rbrace,          /* } */
-  cc_num_char_classes
-};
+/* Streaming parser only: the first byte was '/', and the second decides
+ * between a path and a protocol-relative //authority */
+#define s_stream_slash s_num_states
 
 /* ============================================================================
  * CHARACTER CLASSIFICATION LOOKUP TABLES
  * ============================================================================ */
 
-/* Character class bitmask flags */
-#define CHAR_ALPHA       0x01  /* a-z, A-Z */
-#define CHAR_DIGIT       0x02  /* 0-9 */
-#define CHAR_HEX         0x04  /* 0-9, a-f, A-F */
-#define CHAR_UNRESERVED  0x08  /* - . _ ~ */
-#define CHAR_SUBDELIM    0x10  /* ! $ & ' ( ) * + , ; = */
-#define CHAR_USERINFO    0x20  /* Characters valid in userinfo */
-
-/* Unified character classification lookup table (256 bytes)
- * Uses bitmask flags to support multiple character classes per character
- * Allows single lookup to check multiple character properties
+/* char_flags[256] and its CHAR_* bits, the byte classes and the s_schema
+ * next-state table are generated from tools/url_tables.spec by
+ * tools/gen_tables (`make tables`) into llurl_tables.h.
+ *
+ * char_flags holds one bit per character property, so one lookup tests
+ * several properties at once. url_class_table maps a byte to its class;
+ * only class 0, the bytes outside the spec's `valid` set, is used, by the
+ * invalid-byte scan. The s_schema loop reads url_next_s_schema[byte]; the
+ * other states are coded by hand below, consult no transition table and
+ * have no rules in the spec.
+ * Each profile in the spec (strict, lenient) adds a table set of its own,
+ * reached through url_tables[].
+ * s_dead (0) indicates an error/invalid transition
+ * Special value 0xFF means "stay in current state"
  */
-static const unsigned char char_flags[256] = {
-/*   0 nul    1 soh    2 stx    3 etx    4 eot    5 enq    6 ack    7 bel  */
-        0,       0,       0,       0,       0,       0,       0,       0,
-/*   8 bs     9 ht    10 nl    11 vt    12 np    13 cr    14 so    15 si   */
-        0,       0,       0,       0,       0,       0,       0,       0,
-/*  16 dle   17 dc1   18 dc2   19 dc3   20 dc4   21 nak   22 syn   23 etb */
-        0,       0,       0,       0,       0,       0,       0,       0,
-/*  24 can   25 em    26 sub   27 esc   28 fs    29 gs    30 rs    31 us  */
-        0,       0,       0,       0,       0,       0,       0,       0,
-/*  32 sp    33  !    34  "    35  #    36  $    37  %    38  &    39  '  */
-        0, CHAR_SUBDELIM|CHAR_USERINFO, 0, 0, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO,
-/*  40  (    41  )    42  *    43  +    44  ,    45  -    46  .    47  /  */
-  CHAR_SUBDELIM|CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, CHAR_UNRESERVED|CHAR_USERINFO, CHAR_UNRESERVED|CHAR_USERINFO, 0,
-/*  48  0    49  1    50  2    51  3    52  4    53  5    54  6    55  7  */
-  CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, 
-  CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO,
-/*  56  8    57  9    58  :    59  ;    60  <    61  =    62  >    63  ?  */
-  CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_DIGIT|CHAR_HEX|CHAR_USERINFO, CHAR_USERINFO, CHAR_SUBDELIM|CHAR_USERINFO, 0, CHAR_SUBDELIM|CHAR_USERINFO, 0, 0,
-/*  64  @    65  A    66  B    67  C    68  D    69  E    70  F    71  G  */
-        0, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, 
-        CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/*  72  H    73  I    74  J    75  K    76  L    77  M    78  N    79  O  */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/*  80  P    81  Q    82  R    83  S    84  T    85  U    86  V    87  W  */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/*  88  X    89  Y    90  Z    91  [    92  \    93  ]    94  ^    95  _  */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 0, 0, 0, 0, CHAR_UNRESERVED|CHAR_USERINFO,
-/*  96  `    97  a    98  b    99  c   100  d   101  e   102  f   103  g  */
-        0, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, 
-        CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_HEX|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/* 104  h   105  i   106  j   107  k   108  l   109  m   110  n   111  o  */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/* 112  p   113  q   114  r   115  s   116  t   117  u   118  v   119  w  */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO,
-/* 120  x   121  y   122  z   123  {   124  |   125  }   126  ~   127 del */
-  CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, CHAR_ALPHA|CHAR_USERINFO, 0, 0, 0, CHAR_UNRESERVED, 0,
-/* 128-255: Extended ASCII - all invalid */
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-};
-
-/* Character class lookup table for DFA - maps each byte to a character class */
-static const unsigned char char_class_table[256] = {
-/*   0 nul    1 soh    2 stx    3 etx    4 eot    5 enq    6 ack    7 bel  */
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-/*   8 bs     9 ht    10 nl    11 vt    12 np    13 cr    14 so    15 si   */
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-/*  16 dle   17 dc1   18 dc2   19 dc3   20 dc4   21 nak   22 syn   23 etb */
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-/*  24 can   25 em    26 sub   27 esc   28 fs    29 gs    30 rs    31 us  */
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-/*  32 sp    33  !    34  "    35  #    36  $    37  %    38  &    39  '  */
-  cc_invalid,cc_exclamation,cc_invalid,cc_hash,cc_dollar,cc_percent,cc_ampersand,cc_apostrophe,
-/*  40  (    41  )    42  *    43  +    44  ,    45  -    46  .    47  /  */
-  cc_lparen,cc_rparen,cc_asterisk,cc_plus,cc_comma,cc_dash,cc_dot,cc_slash,
-/*  48  0    49  1    50  2    51  3    52  4    53  5    54  6    55  7  */
-  cc_digit,cc_digit,cc_digit,cc_digit,cc_digit,cc_digit,cc_digit,cc_digit,
-/*  56  8    57  9    58  :    59  ;    60  <    61  =    62  >    63  ?  */
-  cc_digit,cc_digit,cc_colon,cc_semicolon,cc_invalid,cc_equals,cc_invalid,cc_question,
-/*  64  @    65  A    66  B    67  C    68  D    69  E    70  F    71  G  */
-  cc_at,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/*  72  H    73  I    74  J    75  K    76  L    77  M    78  N    79  O  */
-  cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/*  80  P    81  Q    82  R    83  S    84  T    85  U    86  V    87  W  */
-  cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/*  88  X    89  Y    90  Z    91  [    92  \    93  ]    94  ^    95  _  */
-  cc_alpha,cc_alpha,cc_alpha,cc_lbracket,cc_invalid,cc_rbracket,cc_invalid,cc_underscore,
-/*  96  `    97  a    98  b    99  c   100  d   101  e   102  f   103  g  */
-  cc_invalid,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/* 104  h   105  i   106  j   107  k   108  l   109  m   110  n   111  o  */
-  cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/* 112  p   113  q   114  r   115  s   116  t   117  u   118  v   119  w  */
-  cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,cc_alpha,
-/* 120  x   121  y   122  z   123  {   124  |   125  }   126  ~   127 del */
-  cc_alpha,cc_alpha,cc_alpha,cc_lbrace,cc_pipe,cc_rbrace,cc_tilde,cc_invalid,
-/* 128-255: Extended ASCII - all invalid */
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,
-  cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid,cc_invalid
-};
+#define STAY 0xFF
+#include "llurl_tables.h"
 
 /* ============================================================================
  * BRANCH PREDICTION HINTS AND OPTIMIZATION MACROS
@@ -208,6 +92,20 @@ static const unsigned char char_class_table[256] = {
 #define UNLIKELY(x) (x)
 #endif
 
+/* Force inlining of small hot helpers */
+#if defined(__GNUC__) || defined(__clang__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+/* Keep a cold path out of line, and out of its callers' code */
+#if defined(__GNUC__) || defined(__clang__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
 /* Character classification macros - now using unified bitmask lookup table */
 #define IS_ALPHA(c) (char_flags[(unsigned char)(c)] & CHAR_ALPHA)
 #define IS_DIGIT(c) (char_flags[(unsigned char)(c)] & CHAR_DIGIT)
@@ -216,6 +114,12 @@ static const unsigned char char_class_table[256] = {
 #define IS_UNRESERVED(c) (char_flags[(unsigned char)(c)] & CHAR_UNRESERVED)
 #define IS_SUBDELIM(c) (char_flags[(unsigned char)(c)] & CHAR_SUBDELIM)
 
+/* Value of a hex digit already checked with IS_HEX: '0'-'9' keep their low
+ * nibble, letters ('A' 0x41, 'a' 0x61) get 9 added to theirs */
+static inline unsigned char hex_value(unsigned char c) {
+  return (unsigned char)((c & 0x0F) + (c >> 6) * 9);
+}
+
 /* ============================================================================
  * FUSED OPERATIONS FOR HOT PATHS
  * ============================================================================ */
@@ -237,260 +141,6 @@ static const unsigned char char_class_table[256] = {
 #define IS_ALPHANUM_OR_UNRESERVED(c) \
   (char_flags[(unsigned char)(c)] & (CHAR_ALPHA | CHAR_DIGIT | CHAR_UNRESERVED))
 
-/* ============================================================================
- * DFA STATE TRANSITION TABLE
- * ============================================================================ */
-
-/* DFA state transition table: url_state_table[current_state][char_class] = next_state
- * This table drives the state machine, eliminating most switch-case overhead
- * s_dead (0) indicates an error/invalid transition
- * Special value 0xFF means "stay in current state"
- */
-#define STAY 0xFF
-static const unsigned char url_state_table[s_num_states][cc_num_char_classes] = {
-  /* s_dead - error state, all transitions lead to dead */
-  { s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead },
-
-  /* s_start - initial state */
-  { s_dead,       /* cc_invalid */
-    s_schema,     /* cc_alpha - start of schema */
-    s_dead,       /* cc_digit */
-    s_path,       /* cc_slash - relative URL */
-    s_dead,       /* cc_colon */
-    s_dead,       /* cc_question */
-    s_dead,       /* cc_hash */
-    s_dead,       /* cc_at */
-    s_dead,       /* cc_dot */
-    s_dead,       /* cc_dash */
-    s_dead,       /* cc_plus */
-    s_dead,       /* cc_percent */
-    s_dead,       /* cc_ampersand */
-    s_dead,       /* cc_equals */
-    s_dead,       /* cc_semicolon */
-    s_dead,       /* cc_dollar */
-    s_dead,       /* cc_exclamation */
-    s_path,       /* cc_asterisk - * for asterisk-form */
-    s_dead,       /* cc_comma */
-    s_dead,       /* cc_lparen */
-    s_dead,       /* cc_rparen */
-    s_dead,       /* cc_apostrophe */
-    s_dead,       /* cc_underscore */
-    s_dead,       /* cc_tilde */
-    s_dead,       /* cc_lbracket */
-    s_dead,       /* cc_rbracket */
-    s_dead,       /* cc_pipe */
-    s_dead,       /* cc_lbrace */
-    s_dead },     /* cc_rbrace */
-
-  /* s_schema - parsing schema (http, https, etc.) */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    s_dead,       /* cc_slash */
-    s_schema_slash, /* cc_colon - end of schema */
-    s_dead,       /* cc_question */
-    s_dead,       /* cc_hash */
-    s_dead,       /* cc_at */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    s_dead,       /* cc_percent */
-    s_dead,       /* cc_ampersand */
-    s_dead,       /* cc_equals */
-    s_dead,       /* cc_semicolon */
-    s_dead,       /* cc_dollar */
-    s_dead,       /* cc_exclamation */
-    s_dead,       /* cc_asterisk */
-    s_dead,       /* cc_comma */
-    s_dead,       /* cc_lparen */
-    s_dead,       /* cc_rparen */
-    s_dead,       /* cc_apostrophe */
-    s_dead,       /* cc_underscore */
-    s_dead,       /* cc_tilde */
-    s_dead,       /* cc_lbracket */
-    s_dead,       /* cc_rbracket */
-    s_dead,       /* cc_pipe */
-    s_dead,       /* cc_lbrace */
-    s_dead },     /* cc_rbrace */
-
-  /* s_schema_slash - expect first / after schema: */
-  { s_dead, s_dead, s_dead, s_schema_slash_slash, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead },
-
-  /* s_schema_slash_slash - expect second / after schema:/ */
-  { s_dead, s_dead, s_dead, s_server_start, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead },
-
-  /* s_server_start - start of server/host, handled specially in code */
-  { s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead },
-
-  /* s_server - parsing server/host */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    s_path,       /* cc_slash - end of host, start path */
-    STAY,         /* cc_colon - port separator or IPv6 */
-    s_query_or_fragment, /* cc_question - start query */
-    s_dead,       /* cc_hash */
-    s_server_with_at, /* cc_at - previous was userinfo */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    STAY,         /* cc_percent */
-    STAY,         /* cc_ampersand */
-    STAY,         /* cc_equals */
-    STAY,         /* cc_semicolon */
-    STAY,         /* cc_dollar */
-    STAY,         /* cc_exclamation */
-    STAY,         /* cc_asterisk */
-    STAY,         /* cc_comma */
-    STAY,         /* cc_lparen */
-    STAY,         /* cc_rparen */
-    STAY,         /* cc_apostrophe */
-    STAY,         /* cc_underscore */
-    STAY,         /* cc_tilde */
-    STAY,         /* cc_lbracket - IPv6 */
-    STAY,         /* cc_rbracket - IPv6 */
-    STAY,         /* cc_pipe */
-    STAY,         /* cc_lbrace */
-    STAY },       /* cc_rbrace */
-
-  /* s_server_with_at - parsing server after @ (cannot have another @) */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    s_path,       /* cc_slash */
-    STAY,         /* cc_colon */
-    s_query_or_fragment, /* cc_question */
-    s_dead,       /* cc_hash */
-    s_dead,       /* cc_at - double @ not allowed */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    STAY,         /* cc_percent */
-    STAY,         /* cc_ampersand */
-    STAY,         /* cc_equals */
-    STAY,         /* cc_semicolon */
-    STAY,         /* cc_dollar */
-    STAY,         /* cc_exclamation */
-    STAY,         /* cc_asterisk */
-    STAY,         /* cc_comma */
-    STAY,         /* cc_lparen */
-    STAY,         /* cc_rparen */
-    STAY,         /* cc_apostrophe */
-    STAY,         /* cc_underscore */
-    STAY,         /* cc_tilde */
-    STAY,         /* cc_lbracket */
-    STAY,         /* cc_rbracket */
-    STAY,         /* cc_pipe */
-    STAY,         /* cc_lbrace */
-    STAY },       /* cc_rbrace */
-
-  /* s_path - parsing path */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    STAY,         /* cc_slash */
-    STAY,         /* cc_colon */
-    s_query_or_fragment, /* cc_question */
-    s_query_or_fragment, /* cc_hash */
-    STAY,         /* cc_at */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    STAY,         /* cc_percent */
-    STAY,         /* cc_ampersand */
-    STAY,         /* cc_equals */
-    STAY,         /* cc_semicolon */
-    STAY,         /* cc_dollar */
-    STAY,         /* cc_exclamation */
-    STAY,         /* cc_asterisk */
-    STAY,         /* cc_comma */
-    STAY,         /* cc_lparen */
-    STAY,         /* cc_rparen */
-    STAY,         /* cc_apostrophe */
-    STAY,         /* cc_underscore */
-    STAY,         /* cc_tilde */
-    STAY,         /* cc_lbracket */
-    STAY,         /* cc_rbracket */
-    STAY,         /* cc_pipe */
-    STAY,         /* cc_lbrace */
-    STAY },       /* cc_rbrace */
-
-  /* s_query_or_fragment - determining whether ? or # comes next */
-  { s_dead, s_dead, s_dead, s_dead, s_dead, s_query, s_fragment, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead,
-    s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead, s_dead },
-
-  /* s_query - parsing query string */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    STAY,         /* cc_slash */
-    STAY,         /* cc_colon */
-    STAY,         /* cc_question - ? allowed in query */
-    s_fragment,   /* cc_hash - start fragment */
-    STAY,         /* cc_at */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    STAY,         /* cc_percent */
-    STAY,         /* cc_ampersand */
-    STAY,         /* cc_equals */
-    STAY,         /* cc_semicolon */
-    STAY,         /* cc_dollar */
-    STAY,         /* cc_exclamation */
-    STAY,         /* cc_asterisk */
-    STAY,         /* cc_comma */
-    STAY,         /* cc_lparen */
-    STAY,         /* cc_rparen */
-    STAY,         /* cc_apostrophe */
-    STAY,         /* cc_underscore */
-    STAY,         /* cc_tilde */
-    STAY,         /* cc_lbracket */
-    STAY,         /* cc_rbracket */
-    STAY,         /* cc_pipe */
-    STAY,         /* cc_lbrace */
-    STAY },       /* cc_rbrace */
-
-  /* s_fragment - parsing fragment */
-  { s_dead,       /* cc_invalid */
-    STAY,         /* cc_alpha */
-    STAY,         /* cc_digit */
-    STAY,         /* cc_slash */
-    STAY,         /* cc_colon */
-    STAY,         /* cc_question - ? allowed in fragment */
-    STAY,         /* cc_hash - # allowed in fragment */
-    STAY,         /* cc_at */
-    STAY,         /* cc_dot */
-    STAY,         /* cc_dash */
-    STAY,         /* cc_plus */
-    STAY,         /* cc_percent */
-    STAY,         /* cc_ampersand */
-    STAY,         /* cc_equals */
-    STAY,         /* cc_semicolon */
-    STAY,         /* cc_dollar */
-    STAY,         /* cc_exclamation */
-    STAY,         /* cc_asterisk */
-    STAY,         /* cc_comma */
-    STAY,         /* cc_lparen */
-    STAY,         /* cc_rparen */
-    STAY,         /* cc_apostrophe */
-    STAY,         /* cc_underscore */
-    STAY,         /* cc_tilde */
-    STAY,         /* cc_lbracket */
-    STAY,         /* cc_rbracket */
-    STAY,         /* cc_pipe */
-    STAY,         /* cc_lbrace */
-    STAY }        /* cc_rbrace */
-};
-
 /* ============================================================================
  * HELPER FUNCTIONS
  * ============================================================================ */
@@ -500,9 +150,10 @@ static inline int is_alpha(unsigned char ch) {
   return char_flags[ch] & CHAR_ALPHA;
 }
 
-/* Check if character is valid in userinfo (user:pass@host) */
-static inline int is_userinfo_char(unsigned char ch) {
-  return char_flags[ch] & CHAR_USERINFO;
+/* Check if character is valid in userinfo (user:pass@host), by the
+ * char_flags of a table set */
+static inline int is_userinfo_char(const unsigned char *flags, unsigned char ch) {
+  return flags[ch] & CHAR_USERINFO;
 }
 
 /* Mark field as present in the URL */
@@ -515,6 +166,87 @@ void http_parser_url_init(struct http_parser_url *u) {
   memset(u, 0, sizeof(*u));
 }
 
+/* Initialize 32-bit URL structure - public API function */
+void http_parser_url32_init(struct http_parser_url32 *u) {
+  memset(u, 0, sizeof(*u));
+}
+
+/* Query pairs recorded by llurl_parse_url_query_index(): up to max are
+ * stored, count is the number found */
+struct query_index {
+  struct llurl_query_pair *pairs;
+  size_t max;
+  size_t count;
+};
+
+/* Parse result being filled: exactly one of n (16-bit offsets) and w (32-bit
+ * offsets) is set. Each entry point passes the other as a NULL constant, so
+ * once the parser core is inlined the width test folds away and the stores
+ * go straight to the caller's struct. q and h are likewise NULL constants
+ * except in the query-indexing and host-decoding entry points. */
+struct url_out {
+  struct http_parser_url *n;
+  struct http_parser_url32 *w;
+  struct query_index *q;
+  struct llurl_host *h;
+};
+
+#define OUT_WIDE(out) ((out).w != NULL)
+
+/* Field masks for llurl_parse_url_fields(): every field, and the fields
+ * that can still appear once the parser reaches each part of the tail */
+#define ALL_FIELDS          ((1u << UF_MAX) - 1)
+#define TAIL_FROM_FRAGMENT  (1u << UF_FRAGMENT)
+#define TAIL_FROM_QUERY     ((1u << UF_QUERY) | TAIL_FROM_FRAGMENT)
+#define TAIL_FROM_PATH      ((1u << UF_PATH) | TAIL_FROM_QUERY)
+
+static ALWAYS_INLINE void out_mark(struct url_out out, enum http_parser_url_fields field) {
+  if (OUT_WIDE(out)) {
+    out.w->field_set |= (1 << field);
+  } else {
+    out.n->field_set |= (1 << field);
+  }
+}
+
+static ALWAYS_INLINE void out_clear(struct url_out out, enum http_parser_url_fields field) {
+  if (OUT_WIDE(out)) {
+    out.w->field_set &= ~(1 << field);
+  } else {
+    out.n->field_set &= ~(1 << field);
+  }
+}
+
+static ALWAYS_INLINE int out_has(struct url_out out, enum http_parser_url_fields field) {
+  return (OUT_WIDE(out) ? out.w->field_set : out.n->field_set) & (1 << field);
+}
+
+static ALWAYS_INLINE void out_set_field(struct url_out out, enum http_parser_url_fields field,
+                                        size_t off, size_t len) {
+  if (OUT_WIDE(out)) {
+    out.w->field_data[field].off = (uint32_t)off;
+    out.w->field_data[field].len = (uint32_t)len;
+  } else {
+    out.n->field_data[field].off = (uint16_t)off;
+    out.n->field_data[field].len = (uint16_t)len;
+  }
+}
+
+static ALWAYS_INLINE size_t out_off(struct url_out out, enum http_parser_url_fields field) {
+  return OUT_WIDE(out) ? out.w->field_data[field].off : out.n->field_data[field].off;
+}
+
+static ALWAYS_INLINE size_t out_len(struct url_out out, enum http_parser_url_fields field) {
+  return OUT_WIDE(out) ? out.w->field_data[field].len : out.n->field_data[field].len;
+}
+
+static ALWAYS_INLINE void out_set_port(struct url_out out, uint16_t port) {
+  if (OUT_WIDE(out)) {
+    out.w->port = port;
+  } else {
+    out.n->port = port;
+  }
+}
+
 /* Parse port number from string */
 static int parse_port(const char *buf, size_t len, uint16_t *port) {
   /* Optimized with bitmask lookup for digit validation */
@@ -599,17 +331,148 @@ static int parse_port(const char *buf, size_t len, uint16_t *port) {
   return 0;
 }
 
+/* Decode a dotted-quad IPv4 address filling all of p[0 .. len); return 0 if
+ * it is not one. Octets are 1-3 digits, at most 255, without leading
+ * zeros, as inet_pton() accepts them */
+static int decode_ipv4(const char *p, size_t len, uint8_t *addr) {
+  size_t i = 0;
+  for (int k = 0; k < 4; k++) {
+    if (k > 0) {
+      if (i >= len || p[i] != '.') {
+        return 0;
+      }
+      i++;
+    }
+    size_t start = i;
+    unsigned int v = 0;
+    while (i < len && i - start < 3 && IS_DIGIT(p[i])) {
+      v = v * 10 + (unsigned int)(p[i] - '0');
+      i++;
+    }
+    if (i == start || v > 255 || (p[start] == '0' && i - start > 1)) {
+      return 0;
+    }
+    addr[k] = (uint8_t)v;
+  }
+  return i == len;
+}
+
+/* Decode an IPv6 address (RFC 4291 text form) filling all of p[0 .. len);
+ * return 0 if it is malformed. Groups are written as they are read, and
+ * the ones after "::" are moved to the end once their count is known */
+static int decode_ipv6(const char *p, size_t len, uint8_t *addr) {
+  size_t i = 0;
+  int n = 0;    /* bytes written */
+  int gap = -1; /* byte offset of "::" */
+
+  if (len >= 1 && p[0] == ':') {
+    if (len < 2 || p[1] != ':') {
+      return 0;
+    }
+    gap = 0;
+    i = 2;
+  }
+  while (i < len) {
+    size_t start = i;
+    unsigned int v = 0;
+    while (i < len && i - start < 4 && IS_HEX(p[i])) {
+      v = (v << 4) | hex_value((unsigned char)p[i]);
+      i++;
+    }
+    if (i == start) {
+      return 0;
+    }
+    if (i < len && p[i] == '.') {
+      /* Trailing IPv4 part: the last 32 bits */
+      if (n > 12 || !decode_ipv4(p + start, len - start, addr + n)) {
+        return 0;
+      }
+      n += 4;
+      break;
+    }
+    if (n == 16) {
+      return 0;
+    }
+    addr[n++] = (uint8_t)(v >> 8);
+    addr[n++] = (uint8_t)v;
+    if (i == len) {
+      break;
+    }
+    /* Also catches a fifth hex digit */
+    if (p[i] != ':' || ++i == len) {
+      return 0;
+    }
+    if (p[i] == ':') {
+      if (gap >= 0) {
+        return 0;
+      }
+      gap = n;
+      i++;
+    }
+  }
+
+  if (gap >= 0) {
+    /* "::" stands for at least one zero group */
+    if (n == 16) {
+      return 0;
+    }
+    memmove(addr + 16 - (n - gap), addr + gap, (size_t)(n - gap));
+    memset(addr + gap, 0, (size_t)(16 - n));
+  } else if (n != 16) {
+    return 0;
+  }
+  return 1;
+}
+
+/* Classify the host at buf[off .. off + len), brackets already stripped,
+ * and decode IP literals into h, which the caller has zeroed; return 0 on a
+ * malformed IPv6 literal */
+static int decode_host(struct llurl_host *h, const char *buf, size_t off, size_t len,
+                       int bracketed) {
+  if (bracketed) {
+    const char *zone = memchr(buf + off, '%', len);
+    size_t addr_len = zone ? (size_t)(zone - (buf + off)) : len;
+    if (!decode_ipv6(buf + off, addr_len, h->addr)) {
+      return 0;
+    }
+    h->kind = LLURL_HOST_IPV6;
+    if (zone) {
+      /* RFC 6874 writes the '%' as "%25"; a bare '%' is accepted too */
+      size_t zone_off = off + addr_len + 1;
+      if (off + len - zone_off >= 2 && buf[zone_off] == '2' && buf[zone_off + 1] == '5') {
+        zone_off += 2;
+      }
+      if (zone_off == off + len) {
+        return 0;
+      }
+      h->kind = LLURL_HOST_IPV6_ZONE;
+      h->zone_off = (uint16_t)zone_off;
+      h->zone_len = (uint16_t)(off + len - zone_off);
+    }
+    return 1;
+  }
+
+  h->kind = (len > 0 && IS_DIGIT(buf[off]) && decode_ipv4(buf + off, len, h->addr))
+              ? LLURL_HOST_IPV4
+              : LLURL_HOST_REGNAME;
+  if (h->kind == LLURL_HOST_REGNAME) {
+    memset(h->addr, 0, 4);
+  }
+  return 1;
+}
+
 /* Helper to finalize host field and extract port if present */
-static inline int finalize_host_with_port(struct http_parser_url *u,
-                                           const char *buf,
-                                           size_t field_start,
-                                           size_t end_pos,
-                                           size_t port_start,
-                                           int found_colon) {
+static ALWAYS_INLINE int finalize_host_with_port(struct url_out out,
+                                                  const char *buf,
+                                                  size_t field_start,
+                                                  size_t end_pos,
+                                                  size_t port_start,
+                                                  int found_colon) {
   size_t host_off = field_start;
   size_t host_len = (found_colon && port_start > field_start && port_start < end_pos)
                       ? port_start - field_start - 1
                       : end_pos - field_start;
+  int bracketed = 0;
 
   // 检查是否为 IPv6 地址（以 [ 开头，] 在 host 内部且在 port 前）
   if (UNLIKELY(host_len >= 2 && buf[host_off] == '[')) {
@@ -631,10 +494,9 @@ static inline int finalize_host_with_port(struct http_parser_url *u,
       uint16_t port_val;
       size_t port_len = end - after_bracket;
       if (LIKELY(parse_port(buf + after_bracket + 1, port_len, &port_val) == 0)) {
-        u->port = port_val;
-        u->field_data[UF_PORT].off = after_bracket + 1;
-        u->field_data[UF_PORT].len = port_len;
-        mark_field(u, UF_PORT);
+        out_set_port(out, port_val);
+        out_set_field(out, UF_PORT, after_bracket + 1, port_len);
+        out_mark(out, UF_PORT);
         host_len = last_bracket - host_off - 1;
       } else {
         // 端口非法
@@ -644,28 +506,29 @@ static inline int finalize_host_with_port(struct http_parser_url *u,
       host_len = last_bracket - host_off - 1;
     }
     host_off += 1;
+    bracketed = 1;
   }
 
   if (found_colon && port_start > field_start && port_start < end_pos) {
     uint16_t port_val;
     size_t port_len = end_pos - port_start;
     if (LIKELY(parse_port(buf + port_start, port_len, &port_val) == 0)) {
-      u->port = port_val;
-      u->field_data[UF_HOST].off = host_off;
-      u->field_data[UF_HOST].len = host_len;
-      u->field_data[UF_PORT].off = port_start;
-      u->field_data[UF_PORT].len = port_len;
-      mark_field(u, UF_HOST);
-      mark_field(u, UF_PORT);
+      out_set_port(out, port_val);
+      out_set_field(out, UF_HOST, host_off, host_len);
+      out_set_field(out, UF_PORT, port_start, port_len);
+      out_mark(out, UF_HOST);
+      out_mark(out, UF_PORT);
     } else {
       // Invalid port, return error
       return 0;
     }
   } else {
     // No port, just write host
-    u->field_data[UF_HOST].off = host_off;
-    u->field_data[UF_HOST].len = host_len;
-    mark_field(u, UF_HOST);
+    out_set_field(out, UF_HOST, host_off, host_len);
+    out_mark(out, UF_HOST);
+  }
+  if (out.h) {
+    return decode_host(out.h, buf, host_off, host_len, bracketed);
   }
   return 1;
 }
@@ -703,305 +566,912 @@ static inline int validate_host_percent_encoding(const char *buf, size_t off, si
 }
 
 /* ============================================================================
- * MAIN URL PARSING FUNCTION
+ * SIMD SCANNING KERNELS
  * ============================================================================ */
 
-/* Parse a URL; return nonzero on failure */
-/* 线程安全说明：本函数无全局状态，结构体独立，适用于多线程环境。 */
-int http_parser_parse_url(const char *buf, size_t buflen,
-                          int is_connect,
-                          struct http_parser_url *u) {
-  enum state state;
-  enum http_parser_url_fields field = UF_MAX;
-  size_t field_start = 0;
-  size_t i;
-  unsigned char ch;
-  size_t port_start = 0; /* Track port position during host parsing */
-  int found_colon = 0;   /* Flag to track if we found : in host */
-  int bracket_depth = 0; /* Track IPv6 bracket depth; negative = malformed (extra ]) */
+/* A scan set describes the bytes that stop a batch scan.
+ *
+ * The scalar view is a table test: byte c is in the set when
+ * (tbl[c] & mask) == 0, e.g. url_class_table with mask 0xFF selects
+ * exactly the class 0 bytes, those never valid in a URL.
+ *
+ * The vector view is a pair of 16-entry nibble tables for pshufb: every
+ * distinct non-empty column of high nibbles is assigned one bit, hi[h] holds
+ * the bit of high nibble h and lo[l] holds the bits of all columns that
+ * contain low nibble l. A byte is in the set iff (lo[c & 15] & hi[c >> 4]).
+ * This works for any set with at most 8 distinct columns; `vector` is 0 when
+ * the set does not fit and only the scalar kernel may be used.
+ */
+struct scan_set {
+  unsigned char lo[16];
+  unsigned char hi[16];
+  const unsigned char *tbl;
+  unsigned char mask;
+  unsigned char vector;
+};
 
-  /* Handle empty URLs */
-  if (UNLIKELY(buflen == 0)) {
+/* Bytes that are invalid in path, query and fragment, per table set */
+#define INVALID_SET(ts, sfx) [ts] = { { 0 }, { 0 }, url_class_table##sfx, 0xFF, 0 },
+static struct scan_set invalid_sets[URL_NUM_TABLE_SETS] = { URL_TABLE_SETS(INVALID_SET) };
+
+/* Bytes that end a run of plain host/userinfo characters in s_server */
+#define HOST_SET(ts, sfx) [ts] = { { 0 }, { 0 }, char_flags##sfx, CHAR_USERINFO, 0 },
+static struct scan_set host_sets[URL_NUM_TABLE_SETS] = { URL_TABLE_SETS(HOST_SET) };
+
+/* No byte is in this set (every entry is nonzero), so scans with it stop
+ * only at their delimiters; used to find '%' and '+' when decoding */
+#define ONES16 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+static const unsigned char no_class_table[256] = {
+  ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16,
+  ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16
+};
+static struct scan_set escape_set = { { 0 }, { 0 }, no_class_table, 0xFF, 0 };
+
+/* Bytes from 0x80; a scan with it is the ASCII check of UTF-8 mode */
+static const unsigned char ascii_class_table[256] = {
+  ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16, ONES16
+};
+static struct scan_set non_ascii_set = { { 0 }, { 0 }, ascii_class_table, 0xFF, 0 };
+
+/* Bytes that are invalid or '#' in a query; scanned with '&' and '=' as
+ * delimiters when the query is indexed */
+static struct scan_set query_set = { { 0 }, { 0 }, char_flags, CHAR_QUERY, 0 };
+
+typedef size_t (*scan_fn)(const unsigned char *p, size_t i, size_t end,
+                          const struct scan_set *set,
+                          unsigned char d1, unsigned char d2);
+
+/* Scalar kernel: return the first index in [i, end) holding a byte of `set`,
+ * `d1` or `d2`, or `end` if there is none */
+static inline size_t scan_span_scalar(const unsigned char *p, size_t i, size_t end,
+                                      const struct scan_set *set,
+                                      unsigned char d1, unsigned char d2) {
+  while (i < end) {
+    unsigned char c = p[i];
+    if (c == d1 || c == d2 || !(set->tbl[c] & set->mask)) {
+      break;
+    }
+    i++;
+  }
+  return i;
+}
+
+static size_t scan_span_scalar_fn(const unsigned char *p, size_t i, size_t end,
+                                  const struct scan_set *set,
+                                  unsigned char d1, unsigned char d2) {
+  return scan_span_scalar(p, i, end, set, d1, d2);
+}
+
+/* Query indexing kernels: return the index of the first byte in [i, end)
+ * that is not part of the query ('#', an invalid byte or end), recording
+ * its pairs in q on the way. Every '&' and '=' is visited, so unlike
+ * scan_span() the vector kernels classify each block once and then walk
+ * its delimiter bits instead of restarting the scan at each one. */
+typedef size_t (*query_index_fn)(const unsigned char *p, size_t i, size_t end,
+                                 struct query_index *q);
+
+#define NO_EQUALS ((size_t)-1)
+
+/* Record the pair [start, end); empty pairs are skipped as in
+ * llurl_query_iter_next() */
+static ALWAYS_INLINE void query_index_add(struct query_index *q, size_t start, size_t eq,
+                                          size_t end) {
+  if (end == start) {
+    return;
+  }
+  if (q->count < q->max) {
+    struct llurl_query_pair *pair = &q->pairs[q->count];
+    pair->key_off = (uint32_t)start;
+    pair->key_len = (uint32_t)((eq < end ? eq : end) - start);
+    pair->value_off = (uint32_t)(eq < end ? eq + 1 : end);
+    pair->value_len = (uint32_t)(eq < end ? end - eq - 1 : 0);
+  }
+  q->count++;
+}
+
+/* Handle byte j, which is not CHAR_QUERY; return 1 if it ends the query */
+static ALWAYS_INLINE int query_index_stop(const unsigned char *p, size_t j,
+                                          struct query_index *q,
+                                          size_t *start, size_t *eq) {
+  if (p[j] == '=') {
+    if (*eq == NO_EQUALS) {
+      *eq = j;
+    }
+    return 0;
+  }
+  query_index_add(q, *start, *eq, j);
+  if (p[j] != '&') {
     return 1;
   }
+  *start = j + 1;
+  *eq = NO_EQUALS;
+  return 0;
+}
 
-  /* Optimize: Detect initial state early to reduce branching */
-  if (is_connect) {
-    /* CONNECT requests expect authority form (host:port) */
-    state = s_server_start;
-    field = UF_HOST;
-    field_start = 0;
-    mark_field(u, field);
-  } else {
-    /* Fast initial state detection to avoid unnecessary transitions */
-    ch = (unsigned char)buf[0];
-    if (ch == '/') {
-      /* Check for protocol-relative URL (//host/path) */
-      if (buflen >= 2 && buf[1] == '/') {
-        /* Protocol-relative URL - parse directly from host without schema */
-        /* Schema is not set - caller is responsible for default schema */
-        /* Skip the leading // by starting from index 2 */
-        i = 2;
-        if (i >= buflen) {
-          /* URL is just "//" with nothing after - invalid */
-          return 1;
-        }
-        state = s_server_start;
-        field = UF_HOST;
-        field_start = i;
-        mark_field(u, field);
-        goto start_parsing; /* Jump directly to parsing loop */
-      } else {
-        /* Relative URL - start directly at path */
-        state = s_path;
-        field = UF_PATH;
-        field_start = 0;
-        mark_field(u, field);
-      }
-    } else if (ch == '*') {
-      /* Asterisk form - special path */
-      state = s_path;
-      field = UF_PATH;
-      field_start = 0;
-      mark_field(u, field);
-    } else if (LIKELY(is_alpha(ch))) {
-      /* Absolute URL with schema */
-      /* Fast path for common schemas - avoids character-by-character parsing */
-      /* Check for http:// or https:// */
-      if (buflen >= 7 && buf[0] == 'h' && buf[1] == 't' && buf[2] == 't' && buf[3] == 'p') {
-        if (buflen >= 8 && buf[4] == 's' && buf[5] == ':') {
-          /* "https:" found (need 6 chars: https:) */
-          u->field_data[UF_SCHEMA].off = 0;
-          u->field_data[UF_SCHEMA].len = 5;
-          mark_field(u, UF_SCHEMA);
-          i = 6;  /* Point to character after ':' */
-          state = s_schema_slash;
-          goto start_parsing;
-        } else if (buf[4] == ':') {
-          /* "http:" found (need 5 chars: http:) */
-          u->field_data[UF_SCHEMA].off = 0;
-          u->field_data[UF_SCHEMA].len = 4;
-          mark_field(u, UF_SCHEMA);
-          i = 5;  /* Point to character after ':' */
-          state = s_schema_slash;
-          goto start_parsing;
-        }
-      }
-      /* Check for ftp:// */
-      else if (buflen >= 4 && buf[0] == 'f' && buf[1] == 't' && buf[2] == 'p' && buf[3] == ':') {
-        /* "ftp:" found */
-        u->field_data[UF_SCHEMA].off = 0;
-        u->field_data[UF_SCHEMA].len = 3;
-        mark_field(u, UF_SCHEMA);
-        i = 4;  /* Point to character after ':' */
-        state = s_schema_slash;
-        goto start_parsing;
-      }
-      /* Check for ws:// or wss:// */
-      else if (buflen >= 3 && buf[0] == 'w' && buf[1] == 's') {
-        if (buflen >= 4 && buf[2] == 's' && buf[3] == ':') {
-          /* "wss:" found */
-          u->field_data[UF_SCHEMA].off = 0;
-          u->field_data[UF_SCHEMA].len = 3;
-          mark_field(u, UF_SCHEMA);
-          i = 4;  /* Point to character after ':' */
-          state = s_schema_slash;
-          goto start_parsing;
-        } else if (buf[2] == ':') {
-          /* "ws:" found */
-          u->field_data[UF_SCHEMA].off = 0;
-          u->field_data[UF_SCHEMA].len = 2;
-          mark_field(u, UF_SCHEMA);
-          i = 3;  /* Point to character after ':' */
-          state = s_schema_slash;
-          goto start_parsing;
-        }
-      }
-      
-      /* Fall back to standard schema parsing for other schemas */
-      state = s_schema;
-      field = UF_SCHEMA;
-      field_start = 0;
-      mark_field(u, field);
-    } else {
-      /* Invalid start character */
-      return 1;
+/* Byte loop from i, continuing the pair that began at start */
+static ALWAYS_INLINE size_t query_index_tail(const unsigned char *p, size_t i, size_t end,
+                                             struct query_index *q,
+                                             size_t start, size_t eq) {
+  for (; i < end; i++) {
+    if (!(char_flags[p[i]] & CHAR_QUERY) && query_index_stop(p, i, q, &start, &eq)) {
+      return i;
     }
   }
+  query_index_add(q, start, eq, end);
+  return end;
+}
 
-  /* Optimized DFA-based parsing loop with batch processing */
-  for (i = 0; i < buflen; i++) {
-start_parsing:
-    ch = (unsigned char)buf[i];
+static size_t query_index_scalar(const unsigned char *p, size_t i, size_t end,
+                                 struct query_index *q) {
+  return query_index_tail(p, i, end, q, i, NO_EQUALS);
+}
 
-    /* Fast batch processing for path state - scan ahead to find delimiters */
-    if (state == s_path) {
-      /* Look ahead to find ? or # to batch process the path */
-      size_t j = i;
-      
-      /* Scalar validation */
-      while (j < buflen) {
-        unsigned char c = (unsigned char)buf[j];
-        if (c == '?' || c == '#') {
-          break;
-        }
-        if (UNLIKELY(char_class_table[c] == cc_invalid)) {
-          return 1;
-        }
-        j++;
-      }
-      
-      if (j > i) {
-        if (j < buflen) {
-          /* Found delimiter, move to just before it */
-          i = j - 1;
-          /* Will process delimiter in next iteration */
-          continue;
-        } else {
-          /* Reached end of buffer, no delimiter found */
-          /* Path continues to end, set i = buflen so final field handling works correctly */
-          i = buflen;
-          break;
-        }
-      }
-      
-      /* Handle delimiter at current position */
-      ch = (unsigned char)buf[i];
-      if (ch == '?' || ch == '#') {
-        /* Save path and transition to s_query_or_fragment state */
-        /* This state will be handled by the switch statement below */
-        u->field_data[field].off = field_start;
-        u->field_data[field].len = i - field_start;
-        state = s_query_or_fragment;
-        i--;
-        continue;
+/* UTF-8 validation kernels: return nonzero if p[0, len) is well-formed
+ * UTF-8 (RFC 3629): no overlong forms, no surrogates, nothing above
+ * U+10FFFF and no sequence cut short */
+typedef int (*utf8_fn)(const unsigned char *p, size_t len);
+
+static int utf8_valid_scalar(const unsigned char *p, size_t len) {
+  size_t i = 0;
+  while (i < len) {
+    unsigned char c = p[i];
+    unsigned char lo = 0x80, hi = 0xBF;
+    size_t n;
+    if (c < 0x80) {
+      i++;
+      continue;
+    }
+    if (c < 0xC2) {
+      return 0; /* Continuation byte, or C0/C1 (overlong) */
+    } else if (c < 0xE0) {
+      n = 1;
+    } else if (c < 0xF0) {
+      n = 2;
+      lo = c == 0xE0 ? 0xA0 : 0x80; /* Overlong */
+      hi = c == 0xED ? 0x9F : 0xBF; /* Surrogates */
+    } else if (c < 0xF5) {
+      n = 3;
+      lo = c == 0xF0 ? 0x90 : 0x80; /* Overlong */
+      hi = c == 0xF4 ? 0x8F : 0xBF; /* Above U+10FFFF */
+    } else {
+      return 0;
+    }
+    if (len - i <= n || p[i + 1] < lo || p[i + 1] > hi) {
+      return 0;
+    }
+    for (size_t k = 2; k <= n; k++) {
+      if ((p[i + k] & 0xC0) != 0x80) {
+        return 0;
       }
+    }
+    i += n + 1;
+  }
+  return 1;
+}
+
+#if defined(LLURL_HAVE_X86_DISPATCH)
+/* Derive the nibble tables of a scan set from its scalar table */
+static void build_scan_set(struct scan_set *set) {
+  uint16_t columns[16];
+  uint16_t groups[8];
+  int ngroups = 0;
+
+  for (int h = 0; h < 16; h++) {
+    columns[h] = 0;
+    for (int l = 0; l < 16; l++) {
+      if (!(set->tbl[(h << 4) | l] & set->mask)) {
+        columns[h] |= (uint16_t)(1u << l);
+      }
+    }
+  }
+
+  memset(set->lo, 0, sizeof(set->lo));
+  memset(set->hi, 0, sizeof(set->hi));
+  set->vector = 0;
+
+  for (int h = 0; h < 16; h++) {
+    int g;
+    if (columns[h] == 0) {
       continue;
     }
-    
-    /* Fast batch processing for query state - use memchr for hardware acceleration */
-    if (state == s_query) {
-      /* Use memchr to find '#' delimiter - hardware optimized */
-      const char *hash_pos = memchr(buf + i, '#', buflen - i);
-      
-      if (hash_pos) {
-        /* Found #, validate characters between current position and # */
-        size_t hash_idx = hash_pos - buf;
-        
-        /* Scalar validation */
-        for (size_t j = i; j < hash_idx; j++) {
-          if (UNLIKELY(char_class_table[(unsigned char)buf[j]] == cc_invalid)) {
-            return 1;
-          }
-        }
-        
-        /* Save query field and transition to fragment */
-        u->field_data[field].off = field_start;
-        u->field_data[field].len = hash_idx - field_start;
-        field = UF_FRAGMENT;
-        field_start = hash_idx + 1;
-        mark_field(u, field);
-        state = s_fragment;
-        i = hash_idx;
-        continue;
-      } else {
-        /* No # found, validate all remaining characters */
-        
-        /* Scalar validation */
-        for (size_t j = i; j < buflen; j++) {
-          if (UNLIKELY(char_class_table[(unsigned char)buf[j]] == cc_invalid)) {
-            return 1;
-          }
-        }
-        
-        /* Query extends to end */
-        i = buflen;
+    for (g = 0; g < ngroups; g++) {
+      if (groups[g] == columns[h]) {
         break;
       }
     }
-    
-    /* Fast batch processing for fragment state - validate and consume to end */
-    if (state == s_fragment) {
-      /* Scalar validation */
-      size_t j = i;
-      while (j < buflen) {
-        if (UNLIKELY(char_class_table[(unsigned char)buf[j]] == cc_invalid)) {
-          return 1;
+    if (g == ngroups) {
+      if (ngroups == 8) {
+        return; /* Too many distinct columns for an 8-bit mask */
+      }
+      groups[ngroups++] = columns[h];
+      for (int l = 0; l < 16; l++) {
+        if (columns[h] & (1u << l)) {
+          set->lo[l] |= (unsigned char)(1u << g);
         }
-        j++;
       }
-      
-      /* Fragment is valid, skip to end */
-      i = buflen - 1;
-      continue;
     }
+    set->hi[h] = (unsigned char)(1u << g);
+  }
+  set->vector = 1;
+}
 
-    /* Schema state with fast path */
-    if (state == s_schema) {
-      enum state next_state = url_state_table[state][char_class_table[ch]];
+/* Classify one 16-byte block: bit k is set when byte k is in the set or is a
+ * delimiter. Always inlined, so it is VEX-encoded inside the AVX2 kernel. */
+__attribute__((target("sse4.2")))
+static ALWAYS_INLINE unsigned int scan_block16(const unsigned char *p,
+                                               __m128i lo_tbl, __m128i hi_tbl,
+                                               __m128i v_d1, __m128i v_d2) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_loadu_si128((const __m128i *)p);
+  __m128i lo = _mm_shuffle_epi8(lo_tbl, _mm_and_si128(v, nibble));
+  __m128i hi = _mm_shuffle_epi8(hi_tbl, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+  __m128i outside = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+  __m128i delim = _mm_or_si128(_mm_cmpeq_epi8(v, v_d1), _mm_cmpeq_epi8(v, v_d2));
+  return (~(unsigned int)_mm_movemask_epi8(outside) & 0xFFFFu) |
+         (unsigned int)_mm_movemask_epi8(delim);
+}
 
-      if (LIKELY(next_state == STAY)) {
-        /* Stay in current state - common case, continue immediately */
-        continue;
+/* Classify one 32-byte block, as scan_block16() does */
+__attribute__((target("avx2")))
+static ALWAYS_INLINE uint32_t scan_block32(const unsigned char *p,
+                                           __m256i lo_tbl, __m256i hi_tbl,
+                                           __m256i v_d1, __m256i v_d2) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i v = _mm256_loadu_si256((const __m256i *)p);
+  __m256i lo = _mm256_shuffle_epi8(lo_tbl, _mm256_and_si256(v, nibble));
+  __m256i hi = _mm256_shuffle_epi8(hi_tbl, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+  __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+  __m256i delim = _mm256_or_si256(_mm256_cmpeq_epi8(v, v_d1), _mm256_cmpeq_epi8(v, v_d2));
+  return ~(uint32_t)_mm256_movemask_epi8(outside) | (uint32_t)_mm256_movemask_epi8(delim);
+}
+
+/* 16 bytes per step; the remainder is handled by the scalar kernel */
+__attribute__((target("sse4.2")))
+static size_t scan_span_sse42(const unsigned char *p, size_t i, size_t end,
+                              const struct scan_set *set,
+                              unsigned char d1, unsigned char d2) {
+  const __m128i lo_tbl = _mm_loadu_si128((const __m128i *)set->lo);
+  const __m128i hi_tbl = _mm_loadu_si128((const __m128i *)set->hi);
+  const __m128i v_d1 = _mm_set1_epi8((char)d1);
+  const __m128i v_d2 = _mm_set1_epi8((char)d2);
+
+  while (i + 16 <= end) {
+    unsigned int mask = scan_block16(p + i, lo_tbl, hi_tbl, v_d1, v_d2);
+    if (mask) {
+      return i + (size_t)__builtin_ctz(mask);
+    }
+    i += 16;
+  }
+  return scan_span_scalar(p, i, end, set, d1, d2);
+}
+
+/* 32 bytes per step, then at most one 16-byte step and the scalar tail.
+ * The remainder must not tail-call the legacy-SSE kernel: that would run
+ * non-VEX code with dirty upper YMM state. */
+__attribute__((target("avx2")))
+static size_t scan_span_avx2(const unsigned char *p, size_t i, size_t end,
+                             const struct scan_set *set,
+                             unsigned char d1, unsigned char d2) {
+  const __m128i lo_tbl128 = _mm_loadu_si128((const __m128i *)set->lo);
+  const __m128i hi_tbl128 = _mm_loadu_si128((const __m128i *)set->hi);
+  const __m128i v_d1_128 = _mm_set1_epi8((char)d1);
+  const __m128i v_d2_128 = _mm_set1_epi8((char)d2);
+  const __m256i lo_tbl = _mm256_broadcastsi128_si256(lo_tbl128);
+  const __m256i hi_tbl = _mm256_broadcastsi128_si256(hi_tbl128);
+  const __m256i v_d1 = _mm256_set1_epi8((char)d1);
+  const __m256i v_d2 = _mm256_set1_epi8((char)d2);
+  unsigned int mask16;
+
+  while (i + 32 <= end) {
+    uint32_t mask = scan_block32(p + i, lo_tbl, hi_tbl, v_d1, v_d2);
+    if (mask) {
+      return i + (size_t)__builtin_ctz(mask);
+    }
+    i += 32;
+  }
+
+  if (i + 16 <= end) {
+    mask16 = scan_block16(p + i, lo_tbl128, hi_tbl128, v_d1_128, v_d2_128);
+    if (mask16) {
+      return i + (size_t)__builtin_ctz(mask16);
+    }
+    i += 16;
+  }
+  return scan_span_scalar(p, i, end, set, d1, d2);
+}
+
+/* Query indexing, 16 bytes per step. query_set already contains '&' and
+ * '=', so the delimiter compares are only there to fill the arguments. */
+__attribute__((target("sse4.2")))
+static size_t query_index_sse42(const unsigned char *p, size_t i, size_t end,
+                                struct query_index *q) {
+  const __m128i lo_tbl = _mm_loadu_si128((const __m128i *)query_set.lo);
+  const __m128i hi_tbl = _mm_loadu_si128((const __m128i *)query_set.hi);
+  const __m128i v_amp = _mm_set1_epi8('&');
+  size_t start = i;
+  size_t eq = NO_EQUALS;
+
+  while (i + 16 <= end) {
+    unsigned int mask = scan_block16(p + i, lo_tbl, hi_tbl, v_amp, v_amp);
+    while (mask) {
+      size_t j = i + (size_t)__builtin_ctz(mask);
+      if (query_index_stop(p, j, q, &start, &eq)) {
+        return j;
       }
+      mask &= mask - 1;
+    }
+    i += 16;
+  }
+  return query_index_tail(p, i, end, q, start, eq);
+}
 
-      if (UNLIKELY(next_state == s_dead)) {
-        return 1;
+/* Query indexing, 32 bytes per step */
+__attribute__((target("avx2")))
+static size_t query_index_avx2(const unsigned char *p, size_t i, size_t end,
+                               struct query_index *q) {
+  const __m128i lo_tbl128 = _mm_loadu_si128((const __m128i *)query_set.lo);
+  const __m128i hi_tbl128 = _mm_loadu_si128((const __m128i *)query_set.hi);
+  const __m256i lo_tbl = _mm256_broadcastsi128_si256(lo_tbl128);
+  const __m256i hi_tbl = _mm256_broadcastsi128_si256(hi_tbl128);
+  const __m256i v_amp = _mm256_set1_epi8('&');
+  size_t start = i;
+  size_t eq = NO_EQUALS;
+
+  while (i + 32 <= end) {
+    uint32_t mask = scan_block32(p + i, lo_tbl, hi_tbl, v_amp, v_amp);
+    while (mask) {
+      size_t j = i + (size_t)__builtin_ctz(mask);
+      if (query_index_stop(p, j, q, &start, &eq)) {
+        return j;
       }
+      mask &= mask - 1;
+    }
+    i += 32;
+  }
+  return query_index_tail(p, i, end, q, start, eq);
+}
 
-      /* Handle state exit actions */
-      if (next_state == s_schema_slash) {
-        /* End of schema - write field data */
-        u->field_data[field].off = field_start;
-        u->field_data[field].len = i - field_start;
-        state = next_state;
-        continue;
+/* UTF-8 validation by the lookup method of Keiser and Lemire ("Validating
+ * UTF-8 In Less Than One Instruction Per Byte", 2021). Each byte and the
+ * one before it index three nibble tables whose AND has a bit set for
+ * every error the pair shows; a continuation after two others is only
+ * right where a lead two or three bytes back asked for it. Bits of the
+ * tables: */
+#define U8_TOO_SHORT   0x01  /* Lead byte not followed by a continuation */
+#define U8_TOO_LONG    0x02  /* Continuation after an ASCII byte */
+#define U8_OVERLONG_3  0x04  /* E0 80-9F */
+#define U8_TOO_LARGE   0x08  /* F4 90-BF, F5-FF 90-BF: above U+10FFFF */
+#define U8_SURROGATE   0x10  /* ED A0-BF: U+D800-U+DFFF */
+#define U8_OVERLONG_2  0x20  /* C0-C1 */
+#define U8_OVERLONG_4  0x40  /* F0 80-8F, and F5-FF 80-8F (too large) */
+#define U8_TWO_CONTS   0x80  /* Continuation after a continuation */
+#define U8_CARRY       (U8_TOO_SHORT | U8_TOO_LONG | U8_TWO_CONTS)
+
+/* By the high nibble of the previous byte */
+static const unsigned char utf8_prev_high[16] = {
+  U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+  U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+  U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS,
+  U8_TOO_SHORT | U8_OVERLONG_2,
+  U8_TOO_SHORT,
+  U8_TOO_SHORT | U8_OVERLONG_3 | U8_SURROGATE,
+  U8_TOO_SHORT | U8_TOO_LARGE | U8_OVERLONG_4
+};
+
+/* By the low nibble of the previous byte */
+static const unsigned char utf8_prev_low[16] = {
+  U8_CARRY | U8_OVERLONG_2 | U8_OVERLONG_3 | U8_OVERLONG_4,
+  U8_CARRY | U8_OVERLONG_2,
+  U8_CARRY,
+  U8_CARRY,
+  U8_CARRY | U8_TOO_LARGE,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4 | U8_SURROGATE,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4,
+  U8_CARRY | U8_TOO_LARGE | U8_OVERLONG_4
+};
+
+/* By the high nibble of the byte itself */
+static const unsigned char utf8_cur_high[16] = {
+  U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+  U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+  U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 | U8_OVERLONG_4,
+  U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 | U8_TOO_LARGE,
+  U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+  U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+  U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT
+};
+
+/* A block ending in these bytes ends inside a sequence: a byte minus its
+ * entry is nonzero only for a lead too close to the end */
+static const unsigned char utf8_last_max[16] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF
+};
+
+/* Error bits of the 16 bytes of `in`, given the block before it */
+__attribute__((target("sse4.2")))
+static ALWAYS_INLINE __m128i utf8_block16(__m128i in, __m128i prev_in) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  __m128i prev1 = _mm_alignr_epi8(in, prev_in, 15);
+  __m128i prev2 = _mm_alignr_epi8(in, prev_in, 14);
+  __m128i prev3 = _mm_alignr_epi8(in, prev_in, 13);
+  __m128i prev_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)utf8_prev_high),
+                                       _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  __m128i prev_low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)utf8_prev_low),
+                                      _mm_and_si128(prev1, nibble));
+  __m128i cur_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)utf8_cur_high),
+                                      _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+  __m128i special = _mm_and_si128(_mm_and_si128(prev_high, prev_low), cur_high);
+  /* Bit 7 set where the byte must be a third (E0-FF two back) or fourth
+   * (F0-FF three back) byte; those are exactly the allowed TWO_CONTS */
+  __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+  __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+  __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+  return _mm_xor_si128(must23, special);
+}
+
+/* 16 bytes per step; all-ASCII blocks only check that the block before
+ * did not end inside a sequence. The last, partial block is padded with
+ * zeros, so a sequence cut short by the end of the input fails as one cut
+ * short by an ASCII byte. URL tails are short, so there is no AVX2 kernel:
+ * a wider block would mostly be padding. */
+__attribute__((target("sse4.2")))
+static int utf8_valid_sse42(const unsigned char *p, size_t len) {
+  const __m128i last_max = _mm_loadu_si128((const __m128i *)utf8_last_max);
+  __m128i prev = _mm_setzero_si128();
+  __m128i error = _mm_setzero_si128();
+  __m128i prev_incomplete = _mm_setzero_si128();
+  unsigned char rest[16] = { 0 };
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(p + i));
+    if (_mm_movemask_epi8(in) == 0) {
+      error = _mm_or_si128(error, prev_incomplete);
+    } else {
+      error = _mm_or_si128(error, utf8_block16(in, prev));
+      prev_incomplete = _mm_subs_epu8(in, last_max);
+    }
+    prev = in;
+  }
+  memcpy(rest, p + i, len - i);
+  error = _mm_or_si128(error, utf8_block16(_mm_loadu_si128((const __m128i *)rest), prev));
+  return _mm_testz_si128(error, error);
+}
+#endif /* LLURL_HAVE_X86_DISPATCH */
+
+/* ============================================================================
+ * RUNTIME CPU DISPATCH
+ * ============================================================================ */
+
+/* Instruction set levels, in increasing order */
+enum scan_isa {
+  isa_scalar = 0,
+  isa_sse42,
+  isa_avx2
+};
+
+static const char *const scan_isa_names[] = { "scalar", "sse42", "avx2" };
+
+/* Selected once at load time; scalar until the constructor has run */
+static scan_fn scan_impl = scan_span_scalar_fn;
+static enum scan_isa scan_isa_active = isa_scalar;
+static query_index_fn query_index_impl = query_index_scalar;
+static utf8_fn utf8_impl = utf8_valid_scalar;
+
+#if defined(LLURL_HAVE_X86_DISPATCH)
+/* Pick the widest kernel the CPU supports. LLURL_ISA=scalar|sse42|avx2 caps
+ * the choice, which lets tests run every kernel on the same machine. */
+__attribute__((constructor)) static void init_scan_dispatch(void) {
+  enum scan_isa isa = isa_scalar;
+  const char *force = getenv("LLURL_ISA");
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) {
+    isa = isa_sse42;
+    if (__builtin_cpu_supports("avx2")) {
+      isa = isa_avx2;
+    }
+  }
+
+  if (force) {
+    for (int k = isa_scalar; k <= isa_avx2; k++) {
+      if (strcmp(force, scan_isa_names[k]) == 0 && (enum scan_isa)k < isa) {
+        isa = (enum scan_isa)k;
       }
+    }
+  }
+
+  for (int ts = 0; ts < URL_NUM_TABLE_SETS; ts++) {
+    build_scan_set(&invalid_sets[ts]);
+    build_scan_set(&host_sets[ts]);
+  }
+  build_scan_set(&escape_set);
+  build_scan_set(&query_set);
+  build_scan_set(&non_ascii_set);
+
+  if (isa == isa_avx2) {
+    scan_impl = scan_span_avx2;
+  } else if (isa == isa_sse42) {
+    scan_impl = scan_span_sse42;
+  }
+  if (isa >= isa_sse42) {
+    utf8_impl = utf8_valid_sse42;
+  }
+  if (query_set.vector) {
+    if (isa == isa_avx2) {
+      query_index_impl = query_index_avx2;
+    } else if (isa == isa_sse42) {
+      query_index_impl = query_index_sse42;
+    }
+  }
+  scan_isa_active = isa;
+}
+#endif
+
+/* Name of the scan kernel in use - public API function */
+const char *llurl_scan_isa(void) {
+  return scan_isa_names[scan_isa_active];
+}
+
+/* Find the first byte in buf[i, end) that is in `set` or equals `d1`/`d2`.
+ * Returns `end` when the whole span is clean. Short spans stay inline. */
+static ALWAYS_INLINE size_t scan_span(const char *buf, size_t i, size_t end,
+                                      const struct scan_set *set,
+                                      unsigned char d1, unsigned char d2) {
+  const unsigned char *p = (const unsigned char *)buf;
+  if (end - i >= 16 && LIKELY(set->vector)) {
+    return scan_impl(p, i, end, set, d1, d2);
+  }
+  return scan_span_scalar(p, i, end, set, d1, d2);
+}
+
+/* ============================================================================
+ * MAIN URL PARSING FUNCTION
+ * ============================================================================ */
+
+/* Field-mask mode: no requested field starts at or after i, and everything
+ * from i on is path, query or fragment. '?' and '#' are valid bytes in all
+ * three, so checking the rest is one scan for bytes outside the URL
+ * character set. The current field is dropped and the loop left for the
+ * final checks. */
+#define SKIP_TAIL()                                                           \
+  {                                                                           \
+    if (validate_rest &&                                                      \
+        UNLIKELY(scan_span(buf, i, buflen, &invalid_sets[ts], '\0', '\0') < buflen)) { \
+      return 1;                                                               \
+    }                                                                         \
+    field = UF_MAX;                                                           \
+    goto loop_end;                                                            \
+  }
+
+/* State transitions in parse_url()
+ *
+ * The loop is written once as a switch on the state. In the default
+ * direct-threaded build, each case also carries a label, and every
+ * transition whose target is known where it is taken (all but the schema
+ * table lookup) loads the next byte and jumps straight to that label. The
+ * switch is then only entered once per URL, and the indirect jump it
+ * compiles to no longer sits on every transition, where mixed traffic
+ * makes it hard to predict. -DLLURL_SWITCH_DISPATCH, or a compiler other
+ * than GCC or Clang, builds the plain switch loop instead, with each
+ * transition going back through the switch.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(LLURL_SWITCH_DISPATCH)
+#define LLURL_THREADED_DISPATCH 1
+#define STATE(s) L_##s: __attribute__((unused)); case s
+#define FALL_INTO(s) goto L_##s
+#define STAY_IN(s)                                                            \
+  do {                                                                        \
+    if (UNLIKELY(++i >= buflen)) {                                            \
+      goto loop_end;                                                          \
+    }                                                                         \
+    ch = (unsigned char)buf[i];                                               \
+    goto L_##s;                                                               \
+  } while (0)
+#define NEXT_STATE(s)                                                         \
+  do {                                                                        \
+    state = (s);                                                              \
+    STAY_IN(s);                                                               \
+  } while (0)
+#define ENTER_STATE(s)                                                        \
+  do {                                                                        \
+    state = (s);                                                              \
+    goto L_##s;                                                               \
+  } while (0)
+#else
+/* No do { } while (0) here: continue must reach the parsing loop */
+#define STATE(s) case s
+#if defined(__has_attribute)
+#if __has_attribute(fallthrough)
+#define FALL_INTO(s) __attribute__((fallthrough))
+#endif
+#endif
+#ifndef FALL_INTO
+#define FALL_INTO(s)
+#endif
+#define STAY_IN(s) continue
+#define NEXT_STATE(s)                                                         \
+  {                                                                           \
+    state = (s);                                                              \
+    continue;                                                                 \
+  }
+#define ENTER_STATE(s)                                                        \
+  {                                                                           \
+    state = (s);                                                              \
+    goto redispatch;                                                          \
+  }
+#endif
+
+/* Parser core shared by all entry points; return nonzero on failure
+ *
+ * want is the mask of fields the caller needs: once none of them can follow
+ * in the path/query/fragment tail, parsing stops there, and validate_rest
+ * says whether the skipped tail must still be checked. The full parsers
+ * pass ALL_FIELDS, which makes every such test fold away. ts selects the
+ * table set (the strictness profile); callers pass a constant, so each
+ * profile gets its own copy of the loop with its tables at fixed
+ * addresses. */
+/* 线程安全说明：本函数无全局状态，结构体独立，适用于多线程环境。 */
+static ALWAYS_INLINE int parse_url(const char *buf, size_t buflen,
+                                   int is_connect,
+                                   struct url_out out,
+                                   unsigned int want,
+                                   int validate_rest,
+                                   enum url_table_set ts) {
+  const unsigned char *flags = url_tables[ts].flags;
+  enum state state;
+  enum http_parser_url_fields field = UF_MAX;
+  size_t field_start = 0;
+  size_t i;
+  unsigned char ch;
+  size_t port_start = 0; /* Track port position during host parsing */
+  int found_colon = 0;   /* Flag to track if we found : in host */
+  int bracket_depth = 0; /* Track IPv6 bracket depth; negative = malformed (extra ]) */
+
+  /* Handle empty URLs */
+  if (UNLIKELY(buflen == 0)) {
+    return 1;
+  }
 
-      /* For other transitions from simple states, update state and fall through */
-      state = next_state;
+  /* Optimize: Detect initial state early to reduce branching */
+  if (is_connect) {
+    /* CONNECT requests expect authority form (host:port) */
+    state = s_server_start;
+    field = UF_HOST;
+    field_start = 0;
+    out_mark(out, field);
+  } else {
+    /* Fast initial state detection to avoid unnecessary transitions */
+    ch = (unsigned char)buf[0];
+    if (ch == '/') {
+      /* Check for protocol-relative URL (//host/path) */
+      if (buflen >= 2 && buf[1] == '/') {
+        /* Protocol-relative URL - parse directly from host without schema */
+        /* Schema is not set - caller is responsible for default schema */
+        /* Skip the leading // by starting from index 2 */
+        i = 2;
+        if (i >= buflen) {
+          /* URL is just "//" with nothing after - invalid */
+          return 1;
+        }
+        state = s_server_start;
+        field = UF_HOST;
+        field_start = i;
+        out_mark(out, field);
+        goto start_parsing; /* Jump directly to parsing loop */
+      } else {
+        /* Relative URL - start directly at path */
+        state = s_path;
+        field = UF_PATH;
+        field_start = 0;
+        out_mark(out, field);
+      }
+    } else if (ch == '*') {
+      /* Asterisk form - special path */
+      state = s_path;
+      field = UF_PATH;
+      field_start = 0;
+      out_mark(out, field);
+    } else if (LIKELY(is_alpha(ch))) {
+      /* Absolute URL with schema */
+      /* Fast path for common schemas - avoids character-by-character parsing */
+      /* Check for http:// or https:// */
+      if (buflen >= 7 && buf[0] == 'h' && buf[1] == 't' && buf[2] == 't' && buf[3] == 'p') {
+        if (buflen >= 8 && buf[4] == 's' && buf[5] == ':') {
+          /* "https:" found (need 6 chars: https:) */
+          out_set_field(out, UF_SCHEMA, 0, 5);
+          out_mark(out, UF_SCHEMA);
+          i = 6;  /* Point to character after ':' */
+          state = s_schema_slash;
+          goto start_parsing;
+        } else if (buf[4] == ':') {
+          /* "http:" found (need 5 chars: http:) */
+          out_set_field(out, UF_SCHEMA, 0, 4);
+          out_mark(out, UF_SCHEMA);
+          i = 5;  /* Point to character after ':' */
+          state = s_schema_slash;
+          goto start_parsing;
+        }
+      }
+      /* Check for ftp:// */
+      else if (buflen >= 4 && buf[0] == 'f' && buf[1] == 't' && buf[2] == 'p' && buf[3] == ':') {
+        /* "ftp:" found */
+        out_set_field(out, UF_SCHEMA, 0, 3);
+        out_mark(out, UF_SCHEMA);
+        i = 4;  /* Point to character after ':' */
+        state = s_schema_slash;
+        goto start_parsing;
+      }
+      /* Check for ws:// or wss:// */
+      else if (buflen >= 3 && buf[0] == 'w' && buf[1] == 's') {
+        if (buflen >= 4 && buf[2] == 's' && buf[3] == ':') {
+          /* "wss:" found */
+          out_set_field(out, UF_SCHEMA, 0, 3);
+          out_mark(out, UF_SCHEMA);
+          i = 4;  /* Point to character after ':' */
+          state = s_schema_slash;
+          goto start_parsing;
+        } else if (buf[2] == ':') {
+          /* "ws:" found */
+          out_set_field(out, UF_SCHEMA, 0, 2);
+          out_mark(out, UF_SCHEMA);
+          i = 3;  /* Point to character after ':' */
+          state = s_schema_slash;
+          goto start_parsing;
+        }
+      }
+      
+      /* Fall back to standard schema parsing for other schemas */
+      state = s_schema;
+      field = UF_SCHEMA;
+      field_start = 0;
+      out_mark(out, field);
+    } else {
+      /* Invalid start character */
+      return 1;
     }
+  }
 
-    /* Handle complex states and state entry actions */
+  /* Optimized DFA-based parsing loop with batch processing. Each state
+   * consumes as much input as it can and then takes the next byte in the
+   * same state (STAY_IN) or a new one (NEXT_STATE), hands the current byte
+   * to a new state (ENTER_STATE), or leaves the loop (goto loop_end). */
+  i = 0;
+start_parsing:
+  for (; i < buflen; i++) {
+    ch = (unsigned char)buf[i];
+redispatch:
     switch (state) {
-      case s_start:
+      /* Fast batch processing for path state - scan ahead to find delimiters */
+      STATE(s_path): {
+        if (!(want & TAIL_FROM_PATH)) {
+          SKIP_TAIL();
+        }
+        /* Look ahead to find ? or # to batch process the path */
+        size_t j = scan_span(buf, i, buflen, &invalid_sets[ts], '?', '#');
+        if (j >= buflen) {
+          /* Path continues to end, set i = buflen so final field handling works correctly */
+          i = buflen;
+          goto loop_end;
+        }
+        if (UNLIKELY(buf[j] != '?' && buf[j] != '#')) {
+          return 1;
+        }
+
+        /* Save path and hand the delimiter to s_query_or_fragment */
+        out_set_field(out, field, field_start, j - field_start);
+        i = j;
+        ch = (unsigned char)buf[j];
+        ENTER_STATE(s_query_or_fragment);
+      }
+
+      /* Fast batch processing for query state - one vector scan finds '#' and
+       * validates the bytes before it */
+      STATE(s_query): {
+        if (!(want & TAIL_FROM_QUERY)) {
+          SKIP_TAIL();
+        }
+        size_t hash_idx = out.q ? query_index_impl((const unsigned char *)buf, i, buflen, out.q)
+                                : scan_span(buf, i, buflen, &invalid_sets[ts], '#', '#');
+
+        if (hash_idx >= buflen) {
+          /* Query extends to end */
+          i = buflen;
+          goto loop_end;
+        }
+        if (UNLIKELY(buf[hash_idx] != '#')) {
+          return 1;
+        }
+
+        /* Save query field and transition to fragment */
+        out_set_field(out, field, field_start, hash_idx - field_start);
+        field = UF_FRAGMENT;
+        field_start = hash_idx + 1;
+        out_mark(out, field);
+        i = hash_idx;
+        NEXT_STATE(s_fragment);
+      }
+
+      /* Fast batch processing for fragment state - validate and consume to end */
+      STATE(s_fragment):
+        if (!(want & TAIL_FROM_FRAGMENT)) {
+          SKIP_TAIL();
+        }
+        if (UNLIKELY(scan_span(buf, i, buflen, &invalid_sets[ts], '\0', '\0') < buflen)) {
+          return 1;
+        }
+
+        /* Fragment is valid, skip to end */
+        i = buflen;
+        goto loop_end;
+
+      /* Schema state with fast path */
+      STATE(s_schema): {
+        enum state next_state = url_tables[ts].next_s_schema[ch];
+
+        if (LIKELY(next_state == STAY)) {
+          /* Stay in current state - common case, continue immediately */
+          STAY_IN(s_schema);
+        }
+
+        if (UNLIKELY(next_state == s_dead)) {
+          return 1;
+        }
+
+        /* Handle state exit actions */
+        if (next_state == s_schema_slash) {
+          /* End of schema - write field data */
+          out_set_field(out, field, field_start, i - field_start);
+          NEXT_STATE(s_schema_slash);
+        }
+
+        /* For other transitions, hand the byte to the new state */
+        state = next_state;
+        goto redispatch;
+      }
+
+      STATE(s_start):
         if (ch == '/' || ch == '*') {
           /* Relative URL starting with path */
-          state = s_path;
           field = UF_PATH;
           field_start = i;
-          mark_field(u, field);
-        } else if (LIKELY(is_alpha(ch))) {
+          out_mark(out, field);
+          NEXT_STATE(s_path);
+        }
+        if (LIKELY(is_alpha(ch))) {
           /* Absolute URL with schema */
-          state = s_schema;
           field = UF_SCHEMA;
           field_start = i;
-          mark_field(u, field);
-        } else {
-          return 1;
+          out_mark(out, field);
+          NEXT_STATE(s_schema);
         }
-        break;
+        return 1;
 
-      case s_schema_slash:
+      STATE(s_schema_slash):
         if (LIKELY(ch == '/')) {
-          state = s_schema_slash_slash;
-        } else {
-          return 1;
+          NEXT_STATE(s_schema_slash_slash);
         }
-        break;
+        return 1;
 
-      case s_schema_slash_slash:
+      STATE(s_schema_slash_slash):
         if (LIKELY(ch == '/')) {
-          state = s_server_start;
-        } else {
-          return 1;
+          NEXT_STATE(s_server_start);
         }
-        break;
+        return 1;
 
-      case s_server_start:
+      STATE(s_server_start):
         field = UF_HOST;
         field_start = i;
-        mark_field(u, field);
+        out_mark(out, field);
         state = s_server;
         found_colon = 0;
         port_start = 0;
@@ -1011,72 +1481,66 @@ start_parsing:
           return 1;
         }
         /* Fall through to s_server */
+        FALL_INTO(s_server);
         /* FALLTHROUGH */
 
-      case s_server:
-      case s_server_with_at: {
+      STATE(s_server):
+      STATE(s_server_with_at): {
         /* Batch scanning optimization for server state */
         /* When not in bracket and seeing regular characters, scan ahead to next delimiter */
         if (bracket_depth == 0 && ch != '@' && ch != '[' && ch != ':' && 
-            ch != '/' && ch != '?' && ch != '#' && is_userinfo_char(ch)) {
-          /* Fast scan to next delimiter */
-          size_t j = i + 1;
-          while (j < buflen) {
+            ch != '/' && ch != '?' && ch != '#' && is_userinfo_char(flags, ch)) {
+          /* Fast scan to next delimiter; every delimiter except ':' is
+           * already outside the userinfo set */
+          size_t j = scan_span(buf, i + 1, buflen, &host_sets[ts], ':', ':');
+          if (j < buflen) {
             unsigned char c = (unsigned char)buf[j];
-            if (c == '@' || c == '[' || c == ':' || c == '/' || c == '?' || c == '#') {
-              break;
-            }
-            if (!is_userinfo_char(c)) {
+            if (c != '@' && c != '[' && c != ':' && c != '/' && c != '?' && c != '#') {
               return 1;
             }
-            j++;
           }
           /* Skip ahead if we found multiple valid characters */
           if (j > i + 1) {
             i = j - 1;
-            continue;
+            STAY_IN(s_server);
           }
         }
         
         /* 优化分支结构，减少循环内条件判断 */
         if (ch == '/') {
-          if (!finalize_host_with_port(u, buf, field_start, i, port_start, found_colon)) {
+          if (!finalize_host_with_port(out, buf, field_start, i, port_start, found_colon)) {
             return 1;
           }
           field = UF_PATH;
           field_start = i;
-          mark_field(u, field);
-          state = s_path;
-          break;
+          out_mark(out, field);
+          NEXT_STATE(s_path);
         }
         if (ch == '?') {
-          if (!finalize_host_with_port(u, buf, field_start, i, port_start, found_colon)) {
+          if (!finalize_host_with_port(out, buf, field_start, i, port_start, found_colon)) {
             return 1;
           }
           field = UF_QUERY;
           field_start = i + 1;
-          mark_field(u, field);
-          state = s_query;
-          break;
+          out_mark(out, field);
+          NEXT_STATE(s_query);
         }
         if (ch == '@') {
           if (UNLIKELY(state == s_server_with_at)) {
             return 1;
           }
           if (field == UF_HOST) {
-            u->field_data[UF_USERINFO].off = field_start;
-            u->field_data[UF_USERINFO].len = i - field_start;
-            mark_field(u, UF_USERINFO);
-            u->field_set &= ~(1 << UF_HOST);
+            out_set_field(out, UF_USERINFO, field_start, i - field_start);
+            out_mark(out, UF_USERINFO);
+            out_clear(out, UF_HOST);
           }
-          state = s_server_with_at;
           field_start = i + 1;
           field = UF_HOST;
-          mark_field(u, field);
+          out_mark(out, field);
           found_colon = 0;
           port_start = 0;
           bracket_depth = 0;
-          break;
+          NEXT_STATE(s_server_with_at);
         }
         if (ch == '[') {
           /* IPv6 fast path - batch process the entire IPv6 address */
@@ -1118,91 +1582,1282 @@ start_parsing:
           /* Move to closing bracket */
           i = bracket_pos;
           bracket_depth = 0;
-          break;
+          STAY_IN(s_server);
         }
         if (ch == ']') {
           bracket_depth--;
           if (UNLIKELY(bracket_depth < 0)) {
             return 1;
           }
-          break;
+          STAY_IN(s_server);
         }
         if (ch == ':') {
           if (bracket_depth == 0 && !found_colon) {
             found_colon = 1;
             port_start = i + 1;
           }
+          STAY_IN(s_server);
+        }
+        /* 用查表方式判断合法 userinfo 字符 */
+        if (!is_userinfo_char(flags, ch)) {
+          return 1;
+        }
+        STAY_IN(s_server);
+      }
+
+      STATE(s_query_or_fragment):
+        if (ch == '?') {
+          field = UF_QUERY;
+          field_start = i + 1;
+          out_mark(out, field);
+          NEXT_STATE(s_query);
+        }
+        if (ch == '#') {
+          field = UF_FRAGMENT;
+          field_start = i + 1;
+          out_mark(out, field);
+          NEXT_STATE(s_fragment);
+        }
+        return 1;
+
+      default:
+        continue;
+    }
+  }
+loop_end:
+
+  /* Handle final field */
+  if (LIKELY(field != UF_MAX)) {
+    if (UNLIKELY(field == UF_HOST)) {
+      /* Handle inline port parsing for final host field */
+      if (!finalize_host_with_port(out, buf, field_start, i, port_start, found_colon)) {
+        return 1;
+      }
+    } else {
+      /* Optimized: Only write field data if not already set, or if it's a field that can be updated
+       * PATH, QUERY, FRAGMENT are typically set once, so we can safely write them
+       * Other fields should only be written if not already marked */
+      if (LIKELY(field == UF_PATH || field == UF_QUERY || field == UF_FRAGMENT || 
+                 !out_has(out, field))) {
+        out_set_field(out, field, field_start, i - field_start);
+      }
+    }
+  }
+
+  /* CONNECT 模式下，必须严格是 host[:port]，不能有 path/query/fragment */
+  if (UNLIKELY(is_connect)) {
+    if (UNLIKELY(state != s_server && state != s_server_with_at)) {
+      return 1;
+    }
+    // 必须包含端口
+    if (UNLIKELY(!out_has(out, UF_PORT))) {
+      return 1;
+    }
+  } else {
+    /* --- ENHANCEMENT: Reject schema with no host (e.g. http://) --- */
+    if (UNLIKELY(out_has(out, UF_SCHEMA) && !out_has(out, UF_HOST))) {
+      return 1;
+    }
+  }
+
+  /* --- ENHANCEMENT: Reject invalid percent-encoding in host, but allow IPv6 zone id --- */
+  if (out_has(out, UF_HOST)) {
+    if (!validate_host_percent_encoding(buf, out_off(out, UF_HOST), out_len(out, UF_HOST))) {
+      return 1;
+    }
+  }
+
+  return 0; /* Success */
+}
+
+/* Parse a URL; return nonzero on failure */
+int http_parser_parse_url(const char *buf, size_t buflen,
+                          int is_connect,
+                          struct http_parser_url *u) {
+  struct url_out out = { u, NULL, NULL, NULL };
+  return parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_DEFAULT);
+}
+
+/* Parse only the requested fields; return nonzero on failure */
+int llurl_parse_url_fields(const char *buf, size_t buflen,
+                           int is_connect,
+                           unsigned int fields,
+                           unsigned int flags,
+                           struct http_parser_url *u) {
+  struct url_out out = { u, NULL, NULL, NULL };
+  int rv = parse_url(buf, buflen, is_connect, out, fields & ALL_FIELDS,
+                     (flags & LLURL_VALIDATE_REST) != 0, URL_TABLES_DEFAULT);
+  u->field_set &= fields;
+  return rv;
+}
+
+/* Parse a URL with 32-bit offsets; return nonzero on failure */
+int http_parser_parse_url32(const char *buf, size_t buflen,
+                            int is_connect,
+                            struct http_parser_url32 *u) {
+  struct url_out out = { NULL, u, NULL, NULL };
+  return parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_DEFAULT);
+}
+
+/* Parse a URL and index its query pairs; return nonzero on failure */
+int llurl_parse_url_query_index(const char *buf, size_t buflen,
+                                int is_connect,
+                                struct http_parser_url *u,
+                                struct llurl_query_pair *pairs,
+                                size_t max_pairs,
+                                size_t *npairs) {
+  struct query_index q = { pairs, max_pairs, 0 };
+  struct url_out out = { u, NULL, &q, NULL };
+  int rv = parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_DEFAULT);
+  *npairs = q.count;
+  return rv;
+}
+
+/* Parse a URL and decode its host; return nonzero on failure */
+int llurl_parse_url_host(const char *buf, size_t buflen,
+                         int is_connect,
+                         struct http_parser_url *u,
+                         struct llurl_host *host) {
+  struct url_out out = { u, NULL, NULL, host };
+  host->kind = LLURL_HOST_NONE;
+  memset(host->addr, 0, sizeof(host->addr));
+  host->zone_off = 0;
+  host->zone_len = 0;
+  return parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_DEFAULT);
+}
+
+/* Whether buf holds a byte from 0x80; a vector scan, as UTF-8 mode asks
+ * this of every URL the ASCII tables rejected */
+static inline int has_non_ascii(const char *buf, size_t len) {
+  return scan_span(buf, 0, len, &non_ascii_set, 0x80, 0x80) < len;
+}
+
+/* UTF-8 mode, after the compat or strict tables rejected a URL with
+ * non-ASCII bytes: parse it again with those allowed in path, query and
+ * fragment, then check they are UTF-8. Out of line and with the table set
+ * chosen at run time, so the retry is one more copy of the parser rather
+ * than one per profile, and stays off the ASCII path. */
+static NOINLINE int parse_url_utf8_retry(const char *buf, size_t buflen,
+                                         int is_connect,
+                                         struct http_parser_url *u,
+                                         enum url_table_set ts) {
+  struct url_out out = { u, NULL, NULL, NULL };
+  http_parser_url_init(u);
+  if (parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, ts) != 0) {
+    return 1;
+  }
+  return !utf8_impl((const unsigned char *)buf, buflen);
+}
+
+/* Parse a URL under a strictness profile; return nonzero on failure */
+int llurl_parse_url_opts(const char *buf, size_t buflen,
+                         const struct llurl_parse_options *opts,
+                         struct http_parser_url *u) {
+  struct url_out out = { u, NULL, NULL, NULL };
+  int is_connect = opts ? opts->is_connect : 0;
+  int utf8 = opts && (opts->flags & LLURL_PARSE_UTF8);
+  int rv;
+
+  /* One specialisation per profile: the switch is the only extra cost */
+  switch (opts ? opts->profile : LLURL_PROFILE_COMPAT) {
+  case LLURL_PROFILE_COMPAT:
+    rv = parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_DEFAULT);
+    if (UNLIKELY(rv != 0) && utf8 && has_non_ascii(buf, buflen)) {
+      return parse_url_utf8_retry(buf, buflen, is_connect, u, URL_TABLES_UTF8);
+    }
+    return rv;
+  case LLURL_PROFILE_STRICT:
+    rv = parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_STRICT);
+    if (UNLIKELY(rv != 0) && utf8 && has_non_ascii(buf, buflen)) {
+      return parse_url_utf8_retry(buf, buflen, is_connect, u, URL_TABLES_STRICT_UTF8);
+    }
+    return rv;
+  case LLURL_PROFILE_LENIENT:
+    rv = parse_url(buf, buflen, is_connect, out, ALL_FIELDS, 1, URL_TABLES_LENIENT);
+    /* The lenient tables take any byte from 0x80, host included */
+    if (rv == 0 && utf8 && has_non_ascii(buf, buflen)) {
+      rv = !utf8_impl((const unsigned char *)buf, buflen);
+    }
+    return rv;
+  default:
+    return 1;
+  }
+}
+
+/* ============================================================================
+ * BATCH PARSING
+ * ============================================================================ */
+
+/* Parse n URLs into structure-of-arrays columns; return the failure count */
+size_t http_parser_parse_url_batch(const char *const *bufs, const size_t *lens,
+                                   size_t n, int is_connect,
+                                   const struct http_parser_url_batch *out) {
+  /* Local copy: stores through status[] (a char type) would otherwise force
+   * every column pointer to be reloaded for each URL */
+  const struct http_parser_url_batch cols = *out;
+  unsigned int columns = 0;
+  size_t failed = 0;
+
+  /* Resolve which field columns were requested once, not per URL */
+  for (int f = 0; f < UF_MAX; f++) {
+    if (cols.off[f] || cols.len[f]) {
+      columns |= 1u << f;
+    }
+  }
+
+  for (size_t k = 0; k < n; k++) {
+    struct http_parser_url u;
+    int status;
+
+    /* Zeroed so that absent fields come out as 0/0 without a test, and
+     * again on failure to drop partial results. The parser is called out
+     * of line: inlining it into this loop, with a scratch struct that is
+     * only partly reset and columns masked by field_set, measured no
+     * faster than this, so the batch is a layout change, not a speedup */
+    memset(&u, 0, sizeof(u));
+    status = http_parser_parse_url(bufs[k], lens[k], is_connect, &u);
+    if (UNLIKELY(status != 0)) {
+      memset(&u, 0, sizeof(u));
+      failed++;
+    }
+
+    if (cols.status) {
+      cols.status[k] = (uint8_t)(status != 0);
+    }
+    if (cols.field_set) {
+      cols.field_set[k] = u.field_set;
+    }
+    if (cols.port) {
+      cols.port[k] = u.port;
+    }
+    for (int f = 0; f < UF_MAX; f++) {
+      if (columns & (1u << f)) {
+        if (cols.off[f]) {
+          cols.off[f][k] = u.field_data[f].off;
+        }
+        if (cols.len[f]) {
+          cols.len[f][k] = u.field_data[f].len;
+        }
+      }
+    }
+  }
+  return failed;
+}
+
+/* ============================================================================
+ * STREAMING PARSING
+ * ============================================================================ */
+
+/* llurl_stream.flags */
+#define STREAM_ZONE_ID       0x01 /* '%' seen inside the current IPv6 literal */
+#define STREAM_HOST_OVERFLOW 0x02 /* Authority outgrew host[] */
+
+/* Start a streaming parse */
+void llurl_stream_init(struct llurl_stream *s, int is_connect) {
+  memset(s, 0, sizeof(*s));
+  s->is_connect = (uint8_t)(is_connect != 0);
+  s->field = UF_MAX;
+  if (is_connect) {
+    /* CONNECT requests expect authority form (host:port) */
+    s->state = s_server_start;
+    s->field = UF_HOST;
+    mark_field(&s->u, UF_HOST);
+  } else {
+    s->state = s_start;
+  }
+}
+
+/* Enter a field at offset start of the joined URL */
+static inline void stream_begin_field(struct llurl_stream *s, enum state state,
+                                      enum http_parser_url_fields field, size_t start) {
+  s->state = state;
+  s->field = field;
+  s->field_start = start;
+  mark_field(&s->u, field);
+}
+
+/* Close the current field at offset end of the joined URL */
+static inline void stream_end_field(struct llurl_stream *s, size_t end) {
+  s->u.field_data[s->field].off = s->field_start;
+  s->u.field_data[s->field].len = end - s->field_start;
+}
+
+/* Copy authority bytes; once they no longer fit the host is rejected */
+static inline void stream_host_append(struct llurl_stream *s, const char *p, size_t n) {
+  if (UNLIKELY(n > (size_t)(LLURL_STREAM_HOST_MAX - s->host_len))) {
+    s->flags |= STREAM_HOST_OVERFLOW;
+    return;
+  }
+  memcpy(s->host + s->host_len, p, n);
+  s->host_len += n;
+}
+
+/* Split the buffered authority into host and port, as the one-shot parser
+ * does over the whole URL, and move the offsets back into the joined URL */
+static int stream_finalize_host(struct llurl_stream *s) {
+  struct http_parser_url *u = &s->u;
+  size_t base = s->field_start;
+  struct url_out out = { u, NULL, NULL, NULL };
+
+  if (UNLIKELY((s->flags & STREAM_HOST_OVERFLOW) || s->bracket_depth != 0)) {
+    return 0;
+  }
+  if (!finalize_host_with_port(out, s->host, 0, s->host_len,
+                               s->found_colon ? s->port_start - base : 0, s->found_colon)) {
+    return 0;
+  }
+  if (!validate_host_percent_encoding(s->host, u->field_data[UF_HOST].off,
+                                      u->field_data[UF_HOST].len)) {
+    return 0;
+  }
+  u->field_data[UF_HOST].off += base;
+  if (u->field_set & (1 << UF_PORT)) {
+    u->field_data[UF_PORT].off += base;
+  }
+  return 1;
+}
+
+/* Feed the next piece of the URL; return nonzero once the URL is invalid */
+int llurl_stream_feed(struct llurl_stream *s, const char *data, size_t len) {
+  struct http_parser_url *u = &s->u;
+  size_t i = 0;
+
+  while (i < len) {
+    unsigned char ch = (unsigned char)data[i];
+    size_t at = s->pos + i; /* Offset of data[i] in the joined URL */
+
+    switch (s->state) {
+      case s_start:
+        if (ch == '/') {
+          s->state = s_stream_slash;
+          i++;
+        } else if (ch == '*') {
+          stream_begin_field(s, s_path, UF_PATH, 0);
+        } else if (LIKELY(is_alpha(ch))) {
+          stream_begin_field(s, s_schema, UF_SCHEMA, 0);
+        } else {
+          goto fail;
+        }
+        break;
+
+      case s_stream_slash:
+        if (ch == '/') {
+          /* Protocol-relative URL; the host starts after "//" */
+          s->state = s_server_start;
+          s->field = UF_HOST;
+          mark_field(u, UF_HOST);
+          i++;
+        } else {
+          stream_begin_field(s, s_path, UF_PATH, 0);
+        }
+        break;
+
+      case s_schema: {
+        unsigned char next = url_next_s_schema[ch];
+        if (LIKELY(next == STAY)) {
+          i++;
+          break;
+        }
+        if (UNLIKELY(next == s_dead)) {
+          goto fail;
+        }
+        /* End of schema */
+        stream_end_field(s, at);
+        s->state = next;
+        i++;
+        break;
+      }
+
+      case s_schema_slash:
+      case s_schema_slash_slash:
+        if (UNLIKELY(ch != '/')) {
+          goto fail;
+        }
+        s->state = (s->state == s_schema_slash) ? s_schema_slash_slash : s_server_start;
+        i++;
+        break;
+
+      case s_server_start:
+        if (UNLIKELY(ch == '/' || ch == '?' || ch == '#')) {
+          goto fail;
+        }
+        stream_begin_field(s, s_server, UF_HOST, at);
+        s->found_colon = 0;
+        s->port_start = 0;
+        s->bracket_depth = 0;
+        s->host_len = 0;
+        /* FALLTHROUGH */
+
+      case s_server:
+      case s_server_with_at: {
+        size_t j;
+
+        if (s->bracket_depth != 0) {
+          /* Inside an IPv6 literal: hex digits, ':' and '.' up to ']', or
+           * anything once a zone ID ('%') has started */
+          const char *close = memchr(data + i, ']', len - i);
+          size_t end = close ? (size_t)(close - data) : len;
+          for (j = i; j < end && !(s->flags & STREAM_ZONE_ID); j++) {
+            unsigned char c = (unsigned char)data[j];
+            if (c == '%') {
+              s->flags |= STREAM_ZONE_ID;
+            } else if (UNLIKELY(!IS_HEX(c) && c != ':' && c != '.')) {
+              goto fail;
+            }
+          }
+          if (close) {
+            end++;
+            s->bracket_depth = 0;
+            s->flags &= ~STREAM_ZONE_ID;
+          }
+          stream_host_append(s, data + i, end - i);
+          i = end;
+          break;
+        }
+
+        /* Copy the run of plain authority bytes, stopping at ':' and at
+         * anything outside the userinfo set */
+        j = scan_span(data, i, len, &host_sets[URL_TABLES_DEFAULT], ':', ':');
+        stream_host_append(s, data + i, j - i);
+        if (j == len) {
+          i = len;
+          break;
+        }
+        i = j;
+        ch = (unsigned char)data[i];
+        at = s->pos + i;
+
+        if (ch == '/') {
+          if (!stream_finalize_host(s)) {
+            goto fail;
+          }
+          stream_begin_field(s, s_path, UF_PATH, at);
+        } else if (ch == '?') {
+          if (!stream_finalize_host(s)) {
+            goto fail;
+          }
+          stream_begin_field(s, s_query, UF_QUERY, at + 1);
+        } else if (ch == '@') {
+          if (UNLIKELY(s->state == s_server_with_at)) {
+            goto fail;
+          }
+          u->field_data[UF_USERINFO].off = s->field_start;
+          u->field_data[UF_USERINFO].len = at - s->field_start;
+          mark_field(u, UF_USERINFO);
+          stream_begin_field(s, s_server_with_at, UF_HOST, at + 1);
+          s->found_colon = 0;
+          s->port_start = 0;
+          s->host_len = 0;
+          s->flags &= ~STREAM_HOST_OVERFLOW;
+          i++;
+          break;
+        } else if (ch == '[') {
+          s->bracket_depth = 1;
+          stream_host_append(s, data + i, 1);
+        } else if (ch == ':') {
+          if (!s->found_colon) {
+            s->found_colon = 1;
+            s->port_start = at + 1;
+          }
+          stream_host_append(s, data + i, 1);
+        } else {
+          /* ']' outside a literal, '#' right after the authority, or a byte
+           * that is not valid in userinfo */
+          goto fail;
+        }
+        i++;
+        break;
+      }
+
+      case s_path: {
+        size_t j = scan_span(data, i, len, &invalid_sets[URL_TABLES_DEFAULT], '?', '#');
+        if (j == len) {
+          i = len;
+          break;
+        }
+        if (UNLIKELY(data[j] != '?' && data[j] != '#')) {
+          goto fail;
+        }
+        stream_end_field(s, s->pos + j);
+        if (data[j] == '?') {
+          stream_begin_field(s, s_query, UF_QUERY, s->pos + j + 1);
+        } else {
+          stream_begin_field(s, s_fragment, UF_FRAGMENT, s->pos + j + 1);
+        }
+        i = j + 1;
+        break;
+      }
+
+      case s_query: {
+        size_t j = scan_span(data, i, len, &invalid_sets[URL_TABLES_DEFAULT], '#', '#');
+        if (j == len) {
+          i = len;
           break;
         }
-        /* 用查表方式判断合法 userinfo 字符 */
-        if (!is_userinfo_char(ch)) {
-          return 1;
+        if (UNLIKELY(data[j] != '#')) {
+          goto fail;
         }
+        stream_end_field(s, s->pos + j);
+        stream_begin_field(s, s_fragment, UF_FRAGMENT, s->pos + j + 1);
+        i = j + 1;
         break;
       }
 
-      case s_query_or_fragment:
-        if (ch == '?') {
-          field = UF_QUERY;
-          field_start = i + 1;
-          mark_field(u, field);
-          state = s_query;
-        } else if (ch == '#') {
-          field = UF_FRAGMENT;
-          field_start = i + 1;
-          mark_field(u, field);
-          state = s_fragment;
-        } else {
-          return 1;
+      case s_fragment:
+        if (UNLIKELY(scan_span(data, i, len, &invalid_sets[URL_TABLES_DEFAULT], '\0', '\0') <
+                     len)) {
+          goto fail;
         }
+        i = len;
         break;
 
       default:
+        /* s_dead: an earlier piece was already invalid */
+        return 1;
+    }
+  }
+
+  s->pos += len;
+  return 0;
+
+fail:
+  s->state = s_dead;
+  return 1;
+}
+
+/* End a streaming parse; return nonzero on failure */
+int llurl_stream_finish(struct llurl_stream *s, struct http_parser_url *u) {
+  struct http_parser_url *r = &s->u;
+  int state = s->state;
+
+  switch (state) {
+    case s_stream_slash:
+      /* The URL is just "/" */
+      stream_begin_field(s, s_path, UF_PATH, 0);
+      stream_end_field(s, s->pos);
+      break;
+
+    case s_path:
+    case s_query:
+    case s_fragment:
+      stream_end_field(s, s->pos);
+      break;
+
+    case s_server:
+    case s_server_with_at:
+      if (!stream_finalize_host(s)) {
+        goto fail;
+      }
+      break;
+
+    default:
+      /* Empty input, no host after "//", unfinished schema, or an earlier
+       * error */
+      goto fail;
+  }
+
+  /* Same final checks as http_parser_parse_url() */
+  if (UNLIKELY(s->is_connect)) {
+    if (UNLIKELY(state != s_server && state != s_server_with_at)) {
+      goto fail;
+    }
+    if (UNLIKELY(!(r->field_set & (1 << UF_PORT)))) {
+      goto fail;
+    }
+  } else if (UNLIKELY((r->field_set & (1 << UF_SCHEMA)) && !(r->field_set & (1 << UF_HOST)))) {
+    goto fail;
+  }
+
+  *u = *r;
+  s->state = s_dead;
+  return 0;
+
+fail:
+  s->state = s_dead;
+  return 1;
+}
+
+/* ============================================================================
+ * PERCENT DECODING
+ * ============================================================================ */
+
+/* Percent-decode src into dst; return nonzero on a malformed escape */
+int llurl_percent_decode(const char *src, size_t len, char *dst, size_t *out_len,
+                         unsigned int flags) {
+  unsigned char plus = (flags & LLURL_DECODE_PLUS) ? '+' : '%';
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len) {
+    /* Copy the run up to the next escape in bulk; nothing to move while
+     * decoding in place and no escape has been seen yet. Back-to-back
+     * escapes (encoded UTF-8) skip the scan. */
+    size_t j = (src[i] == '%') ? i : scan_span(src, i, len, &escape_set, '%', plus);
+    if (j > i) {
+      if (dst + o != src + i) {
+        memmove(dst + o, src + i, j - i);
+      }
+      o += j - i;
+      i = j;
+      if (i == len) {
         break;
+      }
+    }
+
+    if (src[i] == '+') {
+      dst[o++] = ' ';
+      i++;
+      continue;
+    }
+
+    /* '%' must be followed by two hex digits */
+    if (UNLIKELY(len - i < 3 || !IS_HEX(src[i + 1]) || !IS_HEX(src[i + 2]))) {
+      return 1;
     }
+    dst[o++] = (char)((hex_value((unsigned char)src[i + 1]) << 4) |
+                      hex_value((unsigned char)src[i + 2]));
+    i += 3;
   }
 
-  /* Handle final field */
-  if (LIKELY(field != UF_MAX)) {
-    if (UNLIKELY(field == UF_HOST)) {
-      /* Handle inline port parsing for final host field */
-      if (!finalize_host_with_port(u, buf, field_start, i, port_start, found_colon)) {
-        return 1;
+  *out_len = o;
+  return 0;
+}
+
+/* Percent-decode one field of a parsed URL; return nonzero on failure */
+int llurl_decode_field(const char *buf, const struct http_parser_url *u,
+                       enum http_parser_url_fields field, char *dst, size_t *out_len,
+                       unsigned int flags) {
+  if (UNLIKELY((unsigned int)field >= UF_MAX || !(u->field_set & (1 << field)))) {
+    return 1;
+  }
+  return llurl_percent_decode(buf + u->field_data[field].off, u->field_data[field].len,
+                              dst, out_len, flags);
+}
+
+/* ============================================================================
+ * QUERY STRING ITERATION
+ * ============================================================================ */
+
+/* Start iterating over the key=value pairs in buf[off, off + len) */
+void llurl_query_iter_init(struct llurl_query_iter *it, const char *buf, size_t off,
+                           size_t len) {
+  it->buf = buf;
+  it->pos = off;
+  it->end = off + len;
+}
+
+/* Split off the next non-empty pair; return 0 at the end of the query */
+static ALWAYS_INLINE int query_next(struct llurl_query_iter *it, struct llurl_query_pair *pair) {
+  const char *buf = it->buf;
+  size_t pos = it->pos;
+  size_t end = it->end;
+
+  while (pos < end) {
+    const char *amp = memchr(buf + pos, '&', end - pos);
+    size_t pair_end = amp ? (size_t)(amp - buf) : end;
+    const char *eq;
+    size_t key_end, value_off;
+
+    if (pair_end == pos) {
+      /* Empty pair ("&&" or a leading '&') */
+      pos++;
+      continue;
+    }
+    eq = memchr(buf + pos, '=', pair_end - pos);
+    key_end = eq ? (size_t)(eq - buf) : pair_end;
+    value_off = eq ? key_end + 1 : key_end;
+
+    pair->key_off = (uint32_t)pos;
+    pair->key_len = (uint32_t)(key_end - pos);
+    pair->value_off = (uint32_t)value_off;
+    pair->value_len = (uint32_t)(pair_end - value_off);
+    it->pos = pair_end < end ? pair_end + 1 : end;
+    return 1;
+  }
+  it->pos = end;
+  return 0;
+}
+
+/* Return the next pair; 0 when there are no more */
+int llurl_query_iter_next(struct llurl_query_iter *it, struct llurl_query_pair *pair) {
+  return query_next(it, pair);
+}
+
+/* Fill up to max_pairs pairs; return how many were stored */
+size_t llurl_query_iter_fill(struct llurl_query_iter *it, struct llurl_query_pair *pairs,
+                             size_t max_pairs) {
+  size_t n = 0;
+  while (n < max_pairs && query_next(it, &pairs[n])) {
+    n++;
+  }
+  return n;
+}
+
+/* ============================================================================
+ * PATH NORMALIZATION
+ * ============================================================================ */
+
+/* Decode the escape at src[i] if it is an unreserved character, otherwise
+ * copy it with upper-case hex digits; return nonzero if it is malformed.
+ * The escape is read before dst is written, so this works in place. */
+static ALWAYS_INLINE int normalize_escape(const char *src, size_t i, size_t len,
+                                          char *dst, size_t *o) {
+  static const char hex_upper[] = "0123456789ABCDEF";
+  unsigned char v;
+
+  if (UNLIKELY(len - i < 3 || !IS_HEX(src[i + 1]) || !IS_HEX(src[i + 2]))) {
+    return 1;
+  }
+  v = (unsigned char)((hex_value((unsigned char)src[i + 1]) << 4) |
+                      hex_value((unsigned char)src[i + 2]));
+  if (IS_ALPHANUM_OR_UNRESERVED(v)) {
+    dst[(*o)++] = (char)v;
+  } else {
+    dst[(*o)++] = '%';
+    dst[(*o)++] = hex_upper[v >> 4];
+    dst[(*o)++] = hex_upper[v & 0x0F];
+  }
+  return 0;
+}
+
+/* Normalize a path into dst; return nonzero on a malformed escape
+ *
+ * One pass over the segments. Each segment is copied first, so that with
+ * LLURL_NORMALIZE_DECODE_UNRESERVED "%2E" is seen as '.', and then dropped
+ * again if it is a dot segment. ".." moves the output back to the previous
+ * '/', so every output byte is removed at most once. The output never gets
+ * ahead of the input, which makes dst == src safe. */
+int llurl_normalize_path(const char *src, size_t len, char *dst, size_t *out_len,
+                         unsigned int flags) {
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len) {
+    size_t seg_out = o;
+    int has_slash = src[i] == '/';
+    const char *seg;
+    size_t seg_len;
+
+    if (has_slash) {
+      dst[o++] = '/';
+      i++;
+    }
+    /* Segments are short, so a byte loop beats memchr() and memmove() */
+    if (flags & LLURL_NORMALIZE_DECODE_UNRESERVED) {
+      while (i < len && src[i] != '/') {
+        if (src[i] != '%') {
+          dst[o++] = src[i++];
+        } else if (UNLIKELY(normalize_escape(src, i, len, dst, &o))) {
+          return 1;
+        } else {
+          i += 3;
+        }
       }
     } else {
-      /* Optimized: Only write field data if not already set, or if it's a field that can be updated
-       * PATH, QUERY, FRAGMENT are typically set once, so we can safely write them
-       * Other fields should only be written if not already marked */
-      if (LIKELY(field == UF_PATH || field == UF_QUERY || field == UF_FRAGMENT || 
-                 !(u->field_set & (1 << field)))) {
-        u->field_data[field].off = field_start;
-        u->field_data[field].len = i - field_start;
+      while (i < len && src[i] != '/') {
+        dst[o++] = src[i++];
       }
     }
+
+    seg = dst + seg_out + has_slash;
+    seg_len = o - seg_out - (size_t)has_slash;
+    if (UNLIKELY(seg_len - 1 < 2 && seg[0] == '.' && (seg_len == 1 || seg[1] == '.'))) {
+      o = seg_out;
+      if (!has_slash) {
+        /* Leading "./" or "../" of a relative path: drop it with its '/' */
+        while (i < len && src[i] == '/') {
+          i++;
+          if (!(flags & LLURL_NORMALIZE_COLLAPSE_SLASHES)) {
+            break;
+          }
+        }
+        continue;
+      }
+      if (seg_len == 2) {
+        /* Remove the previous segment and the '/' before it */
+        while (o > 0 && dst[o - 1] != '/') {
+          o--;
+        }
+        if (o > 0) {
+          o--;
+        }
+      }
+      /* "/a/." and "/a/b/.." keep their trailing '/' */
+      if (i == len) {
+        dst[o++] = '/';
+      }
+    } else if (seg_len == 0 && i < len && (flags & LLURL_NORMALIZE_COLLAPSE_SLASHES)) {
+      /* Empty segment between two '/' */
+      o = seg_out;
+    }
   }
 
-  /* CONNECT 模式下，必须严格是 host[:port]，不能有 path/query/fragment */
-  if (UNLIKELY(is_connect)) {
-    if (UNLIKELY(state != s_server && state != s_server_with_at)) {
-      return 1;
+  *out_len = o;
+  return 0;
+}
+
+/* ============================================================================
+ * REFERENCE RESOLUTION
+ * ============================================================================ */
+
+/* Output of llurl_resolve(): the target URL and its fields, built together.
+ * Writes past `size` only set `overflow`, so callers check once at the end. */
+struct resolve_out {
+  char *dst;
+  size_t size;
+  size_t o;
+  int overflow;
+  struct http_parser_url *u;
+};
+
+static ALWAYS_INLINE void resolve_append(struct resolve_out *r, const char *p, size_t n) {
+  if (UNLIKELY(n > r->size - r->o)) {
+    r->overflow = 1;
+    return;
+  }
+  memcpy(r->dst + r->o, p, n);
+  r->o += n;
+}
+
+/* Append one field with its delimiter (":" after the scheme, "?" or "#"
+ * before query and fragment) and record it */
+static ALWAYS_INLINE void resolve_field(struct resolve_out *r, enum http_parser_url_fields field,
+                                        const char *before, const char *p, size_t n,
+                                        const char *after) {
+  resolve_append(r, before, strlen(before));
+  r->u->field_data[field].off = (uint16_t)r->o;
+  r->u->field_data[field].len = (uint16_t)n;
+  r->u->field_set |= (1 << field);
+  resolve_append(r, p, n);
+  resolve_append(r, after, strlen(after));
+}
+
+/* Copy "//" and the authority of a parsed URL, moving its userinfo, host and
+ * port offsets to the new position */
+static void resolve_authority(struct resolve_out *r, const char *buf,
+                              const struct http_parser_url *from) {
+  const uint16_t auth_fields = (1 << UF_USERINFO) | (1 << UF_HOST) | (1 << UF_PORT);
+  size_t start = from->field_data[UF_HOST].off;
+  size_t end = start + from->field_data[UF_HOST].len;
+  size_t shift;
+
+  if (start > 0 && buf[start - 1] == '[') {
+    start--;
+    end++;
+  }
+  if (from->field_set & (1 << UF_USERINFO)) {
+    start = from->field_data[UF_USERINFO].off;
+  }
+  if (from->field_set & (1 << UF_PORT)) {
+    end = from->field_data[UF_PORT].off + from->field_data[UF_PORT].len;
+  }
+
+  resolve_append(r, "//", 2);
+  shift = r->o - start;
+  for (int f = 0; f < UF_MAX; f++) {
+    if ((auth_fields & (1 << f)) && (from->field_set & (1 << f))) {
+      r->u->field_data[f].off = (uint16_t)(from->field_data[f].off + shift);
+      r->u->field_data[f].len = from->field_data[f].len;
     }
-    // 必须包含端口
-    if (UNLIKELY(!(u->field_set & (1 << UF_PORT)))) {
+  }
+  r->u->field_set |= from->field_set & auth_fields;
+  r->u->port = from->port;
+  resolve_append(r, buf + start, end - start);
+}
+
+/* Components of the reference; spans point into ref */
+struct resolve_ref {
+  const char *scheme, *path, *query, *fragment;
+  size_t scheme_len, path_len, query_len, fragment_len;
+  int has_query, has_fragment;
+  const struct http_parser_url *auth; /* Parsed reference if it has an authority */
+};
+
+/* Take path, query and fragment of a parsed URL */
+static void resolve_ref_fields(struct resolve_ref *ref, const char *buf,
+                               const struct http_parser_url *u) {
+  ref->path = buf + u->field_data[UF_PATH].off;
+  ref->path_len = (u->field_set & (1 << UF_PATH)) ? u->field_data[UF_PATH].len : 0;
+  ref->has_query = (u->field_set & (1 << UF_QUERY)) != 0;
+  ref->query = buf + u->field_data[UF_QUERY].off;
+  ref->query_len = u->field_data[UF_QUERY].len;
+  ref->has_fragment = (u->field_set & (1 << UF_FRAGMENT)) != 0;
+  ref->fragment = buf + u->field_data[UF_FRAGMENT].off;
+  ref->fragment_len = u->field_data[UF_FRAGMENT].len;
+}
+
+/* Resolve a reference against a parsed base; return nonzero on failure */
+int llurl_resolve(const char *base, const struct http_parser_url *base_u,
+                  const char *ref, size_t ref_len,
+                  char *dst, size_t dst_size, size_t *out_len,
+                  struct http_parser_url *u) {
+  struct resolve_out r = { dst, dst_size < 65536 ? dst_size : 65535, 0, 0, u };
+  struct resolve_ref rr;
+  struct http_parser_url ref_u;
+  size_t scheme_end = 0;
+  size_t path_start;
+  int has_authority;
+
+  memset(&rr, 0, sizeof(rr));
+  http_parser_url_init(u);
+
+  /* A reference with a scheme or an authority is a URL of its own; other
+   * references are split at the first '?' and '#' (RFC 3986 appendix B) */
+  if (ref_len > 0 && is_alpha((unsigned char)ref[0])) {
+    scheme_end = 1;
+    while (scheme_end < ref_len &&
+           (IS_ALPHANUM(ref[scheme_end]) || ref[scheme_end] == '+' ||
+            ref[scheme_end] == '-' || ref[scheme_end] == '.')) {
+      scheme_end++;
+    }
+    if (scheme_end == ref_len || ref[scheme_end] != ':') {
+      scheme_end = 0;
+    }
+  }
+  if (scheme_end > 0 || (ref_len >= 2 && ref[0] == '/' && ref[1] == '/')) {
+    http_parser_url_init(&ref_u);
+    if (http_parser_parse_url(ref, ref_len, 0, &ref_u) != 0) {
       return 1;
     }
+    if (ref_u.field_set & (1 << UF_SCHEMA)) {
+      rr.scheme = ref + ref_u.field_data[UF_SCHEMA].off;
+      rr.scheme_len = ref_u.field_data[UF_SCHEMA].len;
+    }
+    rr.auth = (ref_u.field_set & (1 << UF_HOST)) ? &ref_u : NULL;
+    resolve_ref_fields(&rr, ref, &ref_u);
   } else {
-    /* --- ENHANCEMENT: Reject schema with no host (e.g. http://) --- */
-    if (UNLIKELY((u->field_set & (1 << UF_SCHEMA)) && !(u->field_set & (1 << UF_HOST)))) {
+    size_t q, h;
+    if (UNLIKELY(scan_span(ref, 0, ref_len, &invalid_sets[URL_TABLES_DEFAULT], '\0', '\0') <
+                 ref_len)) {
       return 1;
     }
+    h = scan_span(ref, 0, ref_len, &escape_set, '#', '#');
+    q = scan_span(ref, 0, h, &escape_set, '?', '?');
+    rr.path = ref;
+    rr.path_len = q;
+    rr.has_query = q < h;
+    rr.query = ref + q + 1;
+    rr.query_len = rr.has_query ? h - q - 1 : 0;
+    rr.has_fragment = h < ref_len;
+    rr.fragment = ref + h + 1;
+    rr.fragment_len = rr.has_fragment ? ref_len - h - 1 : 0;
   }
 
-  /* --- ENHANCEMENT: Reject invalid percent-encoding in host, but allow IPv6 zone id --- */
-  if (u->field_set & (1 << UF_HOST)) {
-    if (!validate_host_percent_encoding(buf, u->field_data[UF_HOST].off, u->field_data[UF_HOST].len)) {
-      return 1;
+  /* Scheme and authority (RFC 3986 section 5.2.2) */
+  if (rr.scheme) {
+    resolve_field(&r, UF_SCHEMA, "", rr.scheme, rr.scheme_len, ":");
+  } else if (base_u->field_set & (1 << UF_SCHEMA)) {
+    resolve_field(&r, UF_SCHEMA, "", base + base_u->field_data[UF_SCHEMA].off,
+                  base_u->field_data[UF_SCHEMA].len, ":");
+  }
+  if (rr.auth) {
+    resolve_authority(&r, ref, rr.auth);
+  } else if (!rr.scheme && (base_u->field_set & (1 << UF_HOST))) {
+    resolve_authority(&r, base, base_u);
+  }
+  has_authority = (u->field_set & (1 << UF_HOST)) != 0;
+
+  /* Path: the reference's, the base's, or the two merged; all but the
+   * base's own path lose their dot segments */
+  path_start = r.o;
+  if (rr.scheme || rr.auth || (rr.path_len > 0 && rr.path[0] == '/')) {
+    resolve_append(&r, rr.path, rr.path_len);
+  } else if (rr.path_len == 0) {
+    if (base_u->field_set & (1 << UF_PATH)) {
+      resolve_append(&r, base + base_u->field_data[UF_PATH].off,
+                     base_u->field_data[UF_PATH].len);
+    }
+    if (!rr.has_query && (base_u->field_set & (1 << UF_QUERY))) {
+      rr.has_query = 1;
+      rr.query = base + base_u->field_data[UF_QUERY].off;
+      rr.query_len = base_u->field_data[UF_QUERY].len;
+    }
+  } else {
+    const char *bp = base + base_u->field_data[UF_PATH].off;
+    size_t blen = (base_u->field_set & (1 << UF_PATH)) ? base_u->field_data[UF_PATH].len : 0;
+    while (blen > 0 && bp[blen - 1] != '/') {
+      blen--;
     }
+    if (blen == 0 && (base_u->field_set & (1 << UF_HOST))) {
+      resolve_append(&r, "/", 1);
+    } else {
+      resolve_append(&r, bp, blen);
+    }
+    resolve_append(&r, rr.path, rr.path_len);
+  }
+  if (UNLIKELY(r.overflow)) {
+    return 1;
+  }
+  if (r.o > path_start && !(rr.path_len == 0 && !rr.scheme && !rr.auth)) {
+    size_t path_len;
+    llurl_normalize_path(dst + path_start, r.o - path_start, dst + path_start, &path_len, 0);
+    r.o = path_start + path_len;
+  }
+  /* With an authority an empty path is "/" (RFC 3986 section 6.2.3) */
+  if (r.o == path_start && has_authority) {
+    resolve_append(&r, "/", 1);
+  }
+  if (r.o > path_start) {
+    u->field_data[UF_PATH].off = (uint16_t)path_start;
+    u->field_data[UF_PATH].len = (uint16_t)(r.o - path_start);
+    u->field_set |= (1 << UF_PATH);
   }
 
-  return 0; /* Success */
+  if (rr.has_query) {
+    resolve_field(&r, UF_QUERY, "?", rr.query, rr.query_len, "");
+  }
+  if (rr.has_fragment) {
+    resolve_field(&r, UF_FRAGMENT, "#", rr.fragment, rr.fragment_len, "");
+  }
+  if (UNLIKELY(r.overflow)) {
+    return 1;
+  }
+  *out_len = r.o;
+  return 0;
+}
+
+/* ============================================================================
+ * URL BUILDING
+ * ============================================================================ */
+
+/* Everything llurl_build_url() will write, worked out before writing it */
+struct build_plan {
+  const char *data[UF_MAX];
+  size_t len[UF_MAX];
+  uint16_t field_set;
+  uint16_t port;
+  char port_text[5];
+  int ipv6_host;
+  size_t total;
+};
+
+/* Default port of a scheme, compared case-insensitively; 0 if unknown */
+static uint16_t default_port(const char *scheme, size_t len) {
+  char s[5];
+  if (len < 2 || len > 5) {
+    return 0;
+  }
+  for (size_t k = 0; k < len; k++) {
+    s[k] = (char)(scheme[k] | 0x20);
+  }
+  if (len == 4 && memcmp(s, "http", 4) == 0) {
+    return 80;
+  }
+  if (len == 5 && memcmp(s, "https", 5) == 0) {
+    return 443;
+  }
+  if (len == 2 && memcmp(s, "ws", 2) == 0) {
+    return 80;
+  }
+  if (len == 3 && memcmp(s, "wss", 3) == 0) {
+    return 443;
+  }
+  return 0;
+}
+
+/* Apply overrides and normalization; return nonzero on an invalid port
+ * override, a scheme left without a host, or an output over 65535 bytes */
+static int build_plan(const char *buf, const struct http_parser_url *u,
+                      const struct llurl_url_overrides *ov, struct build_plan *p) {
+  size_t n;
+
+  p->field_set = 0;
+  for (int f = 0; f < UF_MAX; f++) {
+    if (ov && (ov->field_set & (1 << f))) {
+      p->data[f] = ov->data[f];
+      p->len[f] = ov->data[f] ? ov->len[f] : 0;
+    } else {
+      p->data[f] = buf + u->field_data[f].off;
+      p->len[f] = u->field_data[f].len;
+      if (!(u->field_set & (1 << f))) {
+        p->data[f] = NULL;
+      }
+    }
+    if (p->data[f]) {
+      p->field_set |= (uint16_t)(1 << f);
+    }
+  }
+
+  /* Port: from the override text, or the value the parser already converted */
+  p->port = u->port;
+  if (ov && (ov->field_set & (1 << UF_PORT)) && ov->data[UF_PORT] &&
+      parse_port(ov->data[UF_PORT], ov->len[UF_PORT], &p->port) != 0) {
+    return 1;
+  }
+  if ((p->field_set & (1 << UF_PORT)) && (p->field_set & (1 << UF_SCHEMA)) &&
+      p->port == default_port(p->data[UF_SCHEMA], p->len[UF_SCHEMA])) {
+    p->field_set &= (uint16_t)~(1 << UF_PORT);
+  }
+  if (p->field_set & (1 << UF_PORT)) {
+    /* Decimal without leading zeros */
+    char digits[5];
+    unsigned int v = p->port;
+    n = 0;
+    do {
+      digits[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    for (size_t k = 0; k < n; k++) {
+      p->port_text[k] = digits[n - 1 - k];
+    }
+    p->data[UF_PORT] = p->port_text;
+    p->len[UF_PORT] = n;
+  }
+
+  /* Userinfo and port only exist inside an authority */
+  if (!(p->field_set & (1 << UF_HOST))) {
+    p->field_set &= (uint16_t)~((1 << UF_USERINFO) | (1 << UF_PORT));
+  }
+  /* A parsed host is IPv6 if it was bracketed in buf. Otherwise a ':' can
+   * only be the end of an empty port ("http://example.com:/"), which the
+   * parser leaves in the host and which is dropped here. An override host
+   * is IPv6 if it holds a ':'; brackets it brings are taken off, as the
+   * parser reports the host without them. */
+  p->ipv6_host = 0;
+  if (p->field_set & (1 << UF_HOST)) {
+    if (ov && (ov->field_set & (1 << UF_HOST))) {
+      if (p->len[UF_HOST] >= 2 && p->data[UF_HOST][0] == '[' &&
+          p->data[UF_HOST][p->len[UF_HOST] - 1] == ']') {
+        p->data[UF_HOST]++;
+        p->len[UF_HOST] -= 2;
+      }
+      p->ipv6_host = memchr(p->data[UF_HOST], ':', p->len[UF_HOST]) != NULL;
+    } else if (u->field_data[UF_HOST].off > 0 && buf[u->field_data[UF_HOST].off - 1] == '[') {
+      p->ipv6_host = 1;
+    } else if (p->len[UF_HOST] > 0 && p->data[UF_HOST][p->len[UF_HOST] - 1] == ':') {
+      p->len[UF_HOST]--;
+    }
+  }
+
+  /* This parser takes a scheme only before "//" and a host, so "http:/p"
+   * or "http:///p" would not parse again: refuse rather than write it */
+  if ((p->field_set & (1 << UF_SCHEMA)) &&
+      (!(p->field_set & (1 << UF_HOST)) || p->len[UF_HOST] == 0)) {
+    return 1;
+  }
+
+  /* With an authority an empty path is "/" (RFC 3986 section 6.2.3) */
+  if ((p->field_set & (1 << UF_HOST)) && p->len[UF_PATH] == 0) {
+    p->data[UF_PATH] = "/";
+    p->len[UF_PATH] = 1;
+    p->field_set |= (1 << UF_PATH);
+  }
+
+  n = 0;
+  for (int f = 0; f < UF_MAX; f++) {
+    if (p->field_set & (1 << f)) {
+      n += p->len[f];
+    }
+  }
+  n += (p->field_set & (1 << UF_SCHEMA)) ? 1 : 0;        /* ":" */
+  n += (p->field_set & (1 << UF_HOST)) ? 2 : 0;          /* "//" */
+  n += (p->field_set & (1 << UF_USERINFO)) ? 1 : 0;      /* "@" */
+  n += p->ipv6_host ? 2 : 0;                             /* "[]" */
+  n += (p->field_set & (1 << UF_PORT)) ? 1 : 0;          /* ":" */
+  n += (p->field_set & (1 << UF_QUERY)) ? 1 : 0;         /* "?" */
+  n += (p->field_set & (1 << UF_FRAGMENT)) ? 1 : 0;      /* "#" */
+  if (UNLIKELY(n > 65535)) {
+    return 1;
+  }
+  p->total = n;
+  return 0;
+}
+
+/* Copy n bytes, lower-casing ASCII letters outside %XX escapes */
+static size_t build_lower(char *dst, const char *src, size_t n) {
+  for (size_t k = 0; k < n; k++) {
+    unsigned char c = (unsigned char)src[k];
+    if (c == '%' && n - k >= 3) {
+      dst[k] = src[k];
+      dst[k + 1] = src[k + 1];
+      dst[k + 2] = src[k + 2];
+      k += 2;
+      continue;
+    }
+    dst[k] = (char)(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+  }
+  return n;
+}
+
+/* Exact length of the URL llurl_build_url() writes; nonzero on failure */
+int llurl_build_url_length(const char *buf, const struct http_parser_url *u,
+                           const struct llurl_url_overrides *ov, size_t *len) {
+  struct build_plan p;
+  if (build_plan(buf, u, ov, &p) != 0) {
+    return 1;
+  }
+  *len = p.total;
+  return 0;
+}
+
+/* Write a URL with overrides applied; return nonzero on failure */
+int llurl_build_url(const char *buf, const struct http_parser_url *u,
+                    const struct llurl_url_overrides *ov,
+                    char *dst, size_t dst_size, size_t *out_len,
+                    struct http_parser_url *out_u) {
+  struct build_plan p;
+  struct http_parser_url r;
+  size_t o = 0;
+
+  if (build_plan(buf, u, ov, &p) != 0 || p.total > dst_size) {
+    return 1;
+  }
+
+  memset(&r, 0, sizeof(r));
+  r.field_set = p.field_set;
+  r.port = (p.field_set & (1 << UF_PORT)) ? p.port : 0;
+
+#define BUILD_FIELD(f, copy)                                                   \
+  {                                                                            \
+    r.field_data[f].off = (uint16_t)o;                                         \
+    r.field_data[f].len = (uint16_t)p.len[f];                                  \
+    o += copy;                                                                 \
+  }
+
+  if (p.field_set & (1 << UF_SCHEMA)) {
+    BUILD_FIELD(UF_SCHEMA, build_lower(dst + o, p.data[UF_SCHEMA], p.len[UF_SCHEMA]));
+    dst[o++] = ':';
+  }
+  if (p.field_set & (1 << UF_HOST)) {
+    dst[o++] = '/';
+    dst[o++] = '/';
+    if (p.field_set & (1 << UF_USERINFO)) {
+      memcpy(dst + o, p.data[UF_USERINFO], p.len[UF_USERINFO]);
+      BUILD_FIELD(UF_USERINFO, p.len[UF_USERINFO]);
+      dst[o++] = '@';
+    }
+    if (p.ipv6_host) {
+      dst[o++] = '[';
+    }
+    BUILD_FIELD(UF_HOST, build_lower(dst + o, p.data[UF_HOST], p.len[UF_HOST]));
+    if (p.ipv6_host) {
+      dst[o++] = ']';
+    }
+    if (p.field_set & (1 << UF_PORT)) {
+      dst[o++] = ':';
+      memcpy(dst + o, p.data[UF_PORT], p.len[UF_PORT]);
+      BUILD_FIELD(UF_PORT, p.len[UF_PORT]);
+    }
+  }
+  if (p.field_set & (1 << UF_PATH)) {
+    memcpy(dst + o, p.data[UF_PATH], p.len[UF_PATH]);
+    BUILD_FIELD(UF_PATH, p.len[UF_PATH]);
+  }
+  if (p.field_set & (1 << UF_QUERY)) {
+    dst[o++] = '?';
+    memcpy(dst + o, p.data[UF_QUERY], p.len[UF_QUERY]);
+    BUILD_FIELD(UF_QUERY, p.len[UF_QUERY]);
+  }
+  if (p.field_set & (1 << UF_FRAGMENT)) {
+    dst[o++] = '#';
+    memcpy(dst + o, p.data[UF_FRAGMENT], p.len[UF_FRAGMENT]);
+    BUILD_FIELD(UF_FRAGMENT, p.len[UF_FRAGMENT]);
+  }
+#undef BUILD_FIELD
+
+  if (out_u) {
+    *out_u = r;
+  }
+  *out_len = o;
+  return 0;
 }
@@ -59,6 +59,21 @@ struct http_parser_url {
   } field_data[UF_MAX];
 };
 
+/* Result structure for http_parser_parse_url32().
+ *
+ * Same as struct http_parser_url but with 32-bit offsets and lengths, for
+ * URLs longer than 65535 bytes (whose offsets would otherwise be truncated).
+ */
+struct http_parser_url32 {
+  uint16_t field_set;           /* Bitmask of (1 << UF_*) values */
+  uint16_t port;                /* Converted UF_PORT string */
+
+  struct {
+    uint32_t off;               /* Offset into buffer in which field starts */
+    uint32_t len;               /* Length of run in buffer */
+  } field_data[UF_MAX];
+};
+
 /* Initialize a URL structure to zeros before parsing
  *
  * This function must be called before passing the http_parser_url
@@ -83,6 +98,9 @@ void http_parser_url_init(struct http_parser_url *u);
  * Returns:
  *   0 on success, non-zero on failure
  *
+ * Offsets and lengths are 16-bit; for URLs longer than 65535 bytes use
+ * http_parser_parse_url32().
+ *
  * Example URLs:
  *   Normal:  http://example.com:8080/path?query=value#fragment
  *   Connect: example.com:8080
@@ -91,6 +109,674 @@ int http_parser_parse_url(const char *buf, size_t buflen,
                           int is_connect,
                           struct http_parser_url *u);
 
+/* llurl_parse_url_fields() flag: still reject the URL if the part that was
+ * not parsed contains invalid bytes */
+#define LLURL_VALIDATE_REST 0x1
+
+/* Parse only the requested fields of a URL; return nonzero on failure
+ *
+ * Like http_parser_parse_url(), but parsing stops as soon as none of the
+ * requested fields can follow: a request for UF_HOST and UF_PORT stops at
+ * the end of the authority, one for UF_PATH at the end of the path. Only
+ * requested fields are reported in field_set.
+ *
+ * Without LLURL_VALIDATE_REST the bytes after the stopping point are not
+ * examined, so a URL that http_parser_parse_url() rejects may be accepted.
+ * With it, the return value is always the same as http_parser_parse_url();
+ * the rest is still checked, in a single scan rather than field by field.
+ *
+ * Arguments:
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ *   fields     - Bitmask of (1 << UF_*) values to extract
+ *   flags      - 0 or LLURL_VALIDATE_REST
+ *   u          - Pointer to http_parser_url structure to fill, must be initialized
+ *
+ * Returns:
+ *   0 on success, non-zero on failure
+ */
+int llurl_parse_url_fields(const char *buf, size_t buflen,
+                           int is_connect,
+                           unsigned int fields,
+                           unsigned int flags,
+                           struct http_parser_url *u);
+
+/* llurl_percent_decode() flag: decode '+' as a space
+ * (application/x-www-form-urlencoded query strings) */
+#define LLURL_DECODE_PLUS 0x1
+
+/* Percent-decode a string; return nonzero on a malformed escape
+ *
+ * Each %XX (hex digits in either case) becomes one byte; every other byte
+ * is copied unchanged. The result is never longer than the input, so dst
+ * needs at most len bytes and may be src itself to decode in place. No
+ * memory is allocated and no NUL terminator is written.
+ *
+ * Arguments:
+ *   src     - Bytes to decode
+ *   len     - Number of bytes in src
+ *   dst     - Output buffer of at least len bytes, or src
+ *   out_len - Receives the decoded length on success
+ *   flags   - 0 or LLURL_DECODE_PLUS
+ *
+ * Returns:
+ *   0 on success, non-zero if a '%' is not followed by two hex digits
+ */
+int llurl_percent_decode(const char *src, size_t len, char *dst, size_t *out_len,
+                         unsigned int flags);
+
+/* Percent-decode one field of a parsed URL; return nonzero on failure
+ *
+ * Decodes buf[off, off + len) of the given field with
+ * llurl_percent_decode(). To decode in place pass
+ * dst = buf + u->field_data[field].off. Fails if the field is not set.
+ */
+int llurl_decode_field(const char *buf, const struct http_parser_url *u,
+                       enum http_parser_url_fields field, char *dst, size_t *out_len,
+                       unsigned int flags);
+
+/* llurl_normalize_path() flags */
+#define LLURL_NORMALIZE_COLLAPSE_SLASHES   0x1 /* Merge runs of '/' into one */
+#define LLURL_NORMALIZE_DECODE_UNRESERVED  0x2 /* Decode %XX of A-Z a-z 0-9 - . _ ~ */
+
+/* Normalize a path; return nonzero on a malformed escape
+ *
+ * Removes "." and ".." segments as in RFC 3986 section 5.2.4, so
+ * "/a/b/../c/./d" becomes "/a/c/d". ".." never goes above the root.
+ * LLURL_NORMALIZE_COLLAPSE_SLASHES first turns "//" into "/". With
+ * LLURL_NORMALIZE_DECODE_UNRESERVED, escapes of unreserved characters are
+ * decoded and the other escapes get upper-case hex digits (RFC 3986
+ * section 6.2.2). Decoding happens before dot segments are removed, so
+ * "/%2E%2E/" counts as "/../"; "%2F" stays encoded.
+ *
+ * The result is never longer than the input, so dst needs at most len
+ * bytes and may be src itself. One pass, no memory is allocated and no NUL
+ * terminator is written. Usually applied to the UF_PATH field:
+ *   llurl_normalize_path(url + u.field_data[UF_PATH].off,
+ *                        u.field_data[UF_PATH].len, out, &out_len, 0);
+ *
+ * Arguments:
+ *   src     - Path to normalize
+ *   len     - Number of bytes in src
+ *   dst     - Output buffer of at least len bytes, or src
+ *   out_len - Receives the normalized length on success
+ *   flags   - 0 or LLURL_NORMALIZE_* flags
+ *
+ * Returns:
+ *   0 on success, non-zero if LLURL_NORMALIZE_DECODE_UNRESERVED is set and
+ *   a '%' is not followed by two hex digits
+ */
+int llurl_normalize_path(const char *src, size_t len, char *dst, size_t *out_len,
+                         unsigned int flags);
+
+/* Resolve a reference against a parsed base URL; return nonzero on failure
+ *
+ * Implements RFC 3986 section 5.2: "../img/a.png", "?page=2", "#top",
+ * "/abs", "//cdn.example.com/x" and absolute URLs all give the target URL.
+ * The base is only read through base_u, so a page URL is parsed once and
+ * reused for every reference on it. The target is written to dst and its
+ * fields to u directly, with the same result as parsing dst with
+ * http_parser_parse_url(), but without doing so. A reference with a
+ * scheme or a "//" authority is parsed itself; other references are only
+ * checked for bytes the parser would reject.
+ *
+ * Dot segments are removed from merged and reference paths. With an
+ * authority, an empty path becomes "/" (RFC 3986 section 6.2.3).
+ *
+ * Arguments:
+ *   base     - Base URL string
+ *   base_u   - Result of parsing base with http_parser_parse_url()
+ *   ref      - Reference to resolve
+ *   ref_len  - Length of ref
+ *   dst      - Output buffer for the target URL (not NUL-terminated)
+ *   dst_size - Size of dst; targets over 65535 bytes are rejected
+ *   out_len  - Receives the length of the target URL
+ *   u        - Receives the fields of the target URL
+ *
+ * Returns:
+ *   0 on success, non-zero if the reference is not a valid URL or
+ *   relative reference, or the target does not fit in dst
+ */
+int llurl_resolve(const char *base, const struct http_parser_url *base_u,
+                  const char *ref, size_t ref_len,
+                  char *dst, size_t dst_size, size_t *out_len,
+                  struct http_parser_url *u);
+
+/* Field replacements for llurl_build_url()
+ *
+ * For each (1 << UF_*) bit in field_set, data/len replace that field of the
+ * parsed URL, or a NULL data drops the field. Other fields are kept. A port
+ * is given as its decimal text, e.g. "8080".
+ */
+struct llurl_url_overrides {
+  uint16_t field_set;
+  const char *data[UF_MAX];
+  uint16_t len[UF_MAX];
+};
+
+/* Get the exact length llurl_build_url() will write; return nonzero on failure
+ *
+ * Lets callers size a buffer (e.g. on the stack) before building.
+ *
+ * Arguments:
+ *   buf - URL string that was parsed
+ *   u   - Result of parsing buf
+ *   ov  - Field overrides, or NULL
+ *   len - Receives the length of the output
+ *
+ * Returns:
+ *   0 on success, non-zero if a port override is not a valid port, the URL
+ *   would have a scheme but no host, or it would be longer than 65535 bytes
+ */
+int llurl_build_url_length(const char *buf, const struct http_parser_url *u,
+                           const struct llurl_url_overrides *ov, size_t *len);
+
+/* Serialize a parsed URL with fields replaced; return nonzero on failure
+ *
+ * Writes [scheme ":"] ["//" [userinfo "@"] host [":" port]] path
+ * ["?" query] ["#" fragment], normalized on the way:
+ *   - scheme and host are lower-cased (not the hex digits of escapes)
+ *   - the port is written in decimal, and left out if it is the default of
+ *     the scheme (80 for http and ws, 443 for https and wss)
+ *   - a host bracketed in buf, or an override host containing ':', is an
+ *     IPv6 address and is written in brackets
+ *   - an empty port ("http://example.com:/") is dropped with its ':'
+ *   - with a host, an empty path becomes "/"
+ * Userinfo and port are dropped when there is no host. A scheme needs a
+ * non-empty host: this parser rejects "http:/p", so dropping the host (a
+ * NULL host override) or emptying it fails unless the scheme is dropped
+ * too. Other override contents are copied as given; validating them is up
+ * to the caller.
+ *
+ * Arguments:
+ *   buf      - URL string that was parsed
+ *   u        - Result of parsing buf
+ *   ov       - Field overrides, or NULL to only normalize
+ *   dst      - Output buffer (not NUL-terminated)
+ *   dst_size - Size of dst; llurl_build_url_length() gives the exact need
+ *   out_len  - Receives the length of the output
+ *   out_u    - Receives the fields of the output, or NULL
+ *
+ * Returns:
+ *   0 on success, non-zero on an invalid port override, a scheme without
+ *   a host, or if the output does not fit in dst
+ */
+int llurl_build_url(const char *buf, const struct http_parser_url *u,
+                    const struct llurl_url_overrides *ov,
+                    char *dst, size_t dst_size, size_t *out_len,
+                    struct http_parser_url *out_u);
+
+/* One key=value pair of a query string
+ *
+ * Offsets are into the buffer that was parsed, so a key or value can be
+ * passed straight to llurl_percent_decode(). A pair without '=' has an
+ * empty value at the end of its key.
+ */
+struct llurl_query_pair {
+  uint32_t key_off;
+  uint32_t key_len;
+  uint32_t value_off;
+  uint32_t value_len;
+};
+
+/* Cursor over the pairs of a query string; members are private */
+struct llurl_query_iter {
+  const char *buf;
+  size_t pos;
+  size_t end;
+};
+
+/* Start iterating over the '&'-separated pairs in buf[off, off + len)
+ *
+ * Usually the UF_QUERY field of a parsed URL:
+ *   llurl_query_iter_init(&it, url, u.field_data[UF_QUERY].off,
+ *                         u.field_data[UF_QUERY].len);
+ * An absent field (0, 0) yields no pairs.
+ */
+void llurl_query_iter_init(struct llurl_query_iter *it, const char *buf, size_t off,
+                           size_t len);
+
+/* Return the next pair; return 1 and fill *pair, or 0 when none are left
+ *
+ * Empty pairs ("a=1&&b=2", a trailing '&') are skipped. Nothing is
+ * decoded and no memory is allocated.
+ */
+int llurl_query_iter_next(struct llurl_query_iter *it, struct llurl_query_pair *pair);
+
+/* Fill up to max_pairs pairs in one call; return how many were stored
+ *
+ * Same pairs, in the same order, as repeated llurl_query_iter_next() calls.
+ * A return value of max_pairs means there may be more; call again to
+ * continue from where this call stopped.
+ */
+size_t llurl_query_iter_fill(struct llurl_query_iter *it, struct llurl_query_pair *pairs,
+                             size_t max_pairs);
+
+/* Parse a URL and index its query in the same pass; return nonzero on failure
+ *
+ * Same result as http_parser_parse_url(), but the scan over the query also
+ * records its pairs, as llurl_query_iter_next() would return them, into
+ * pairs[0 .. max_pairs). Looking up a parameter afterwards does not touch
+ * the query again. http_parser_parse_url() does no indexing work.
+ *
+ * Arguments:
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ *   u          - Pointer to http_parser_url structure to fill, must be initialized
+ *   pairs      - Array receiving the first max_pairs pairs
+ *   max_pairs  - Capacity of pairs; 0 just counts them
+ *   npairs     - Receives the number of pairs in the query, which may be
+ *                more than max_pairs; 0 when there is no query
+ *
+ * Returns:
+ *   0 on success, non-zero on failure (pairs and *npairs are then undefined)
+ */
+int llurl_parse_url_query_index(const char *buf, size_t buflen,
+                                int is_connect,
+                                struct http_parser_url *u,
+                                struct llurl_query_pair *pairs,
+                                size_t max_pairs,
+                                size_t *npairs);
+
+/* What the host of a URL is, as classified by llurl_parse_url_host() */
+enum llurl_host_kind {
+  LLURL_HOST_NONE = 0,      /* No host (e.g. an origin-form path) */
+  LLURL_HOST_REGNAME,       /* Registered name, including digit strings
+                               that are not a dotted-quad IPv4 address */
+  LLURL_HOST_IPV4,          /* Dotted-quad IPv4 address */
+  LLURL_HOST_IPV6,          /* Bracketed IPv6 literal */
+  LLURL_HOST_IPV6_ZONE      /* Bracketed IPv6 literal with a zone ID */
+};
+
+/* Host details filled by llurl_parse_url_host() */
+struct llurl_host {
+  uint8_t kind;             /* enum llurl_host_kind */
+  uint8_t addr[16];         /* Address in network byte order: 4 bytes for
+                               IPv4, 16 for IPv6, zero otherwise */
+  uint16_t zone_off;        /* Zone ID after "%25" or "%", for
+                               LLURL_HOST_IPV6_ZONE; 0 otherwise */
+  uint16_t zone_len;
+};
+
+/* Parse a URL and decode its host in the same pass; return nonzero on failure
+ *
+ * Same result as http_parser_parse_url(), plus the host kind and, for IP
+ * literals, the binary address as inet_pton() would produce it. Bracketed
+ * literals are held to the IPv6 grammar of RFC 4291 (at most one "::", at
+ * most eight groups, an optional trailing IPv4 part), so inputs such as
+ * "[1::2::3]" that pass http_parser_parse_url()'s character check fail
+ * here. An unbracketed host is IPv4 only if it is exactly four decimal
+ * octets without leading zeros; anything else is a registered name.
+ *
+ * Arguments:
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ *   u          - Pointer to http_parser_url structure to fill, must be initialized
+ *   host       - Receives the host kind and address
+ *
+ * Returns:
+ *   0 on success, non-zero on failure (*host is then undefined)
+ */
+int llurl_parse_url_host(const char *buf, size_t buflen,
+                         int is_connect,
+                         struct http_parser_url *u,
+                         struct llurl_host *host);
+
+/* Which bytes llurl_parse_url_opts() accepts outside the host */
+enum llurl_profile {
+  LLURL_PROFILE_COMPAT = 0, /* As http_parser_parse_url(): RFC 3986 plus
+                               { } | */
+  LLURL_PROFILE_STRICT,     /* RFC 3986 only: { } | fail, '~' is allowed
+                               in the authority */
+  LLURL_PROFILE_LENIENT     /* What browsers send: also space, " < > \ ^ `
+                               and bytes 0x80-0xFF, which may appear in
+                               the host too; control bytes and DEL fail */
+};
+
+/* llurl_parse_url_opts() flag: accept non-ASCII bytes in path, query and
+ * fragment if they are well-formed UTF-8; with LLURL_PROFILE_LENIENT,
+ * require every non-ASCII byte, host included, to be well-formed UTF-8 */
+#define LLURL_PARSE_UTF8 0x1
+
+/* Options for llurl_parse_url_opts(); all zero is http_parser_parse_url() */
+struct llurl_parse_options {
+  int is_connect;           /* Non-zero for a CONNECT request (authority form) */
+  int profile;              /* enum llurl_profile */
+  unsigned int flags;       /* 0 or LLURL_PARSE_UTF8 */
+};
+
+/* Parse a URL under a strictness profile; return nonzero on failure
+ *
+ * Same structure and field rules as http_parser_parse_url(); the profile
+ * only changes which bytes are valid. Each profile has its own generated
+ * tables (see tools/url_tables.spec) and its own inlined copy of the
+ * parser, so a lenient parse is as fast as a default one. Lenient bytes
+ * are accepted as they are: nothing is percent-encoded or normalized, and
+ * '\' is not taken for '/'.
+ *
+ * With LLURL_PARSE_UTF8, well-formed means RFC 3629: overlong forms,
+ * surrogates (U+D800-U+DFFF), code points above U+10FFFF and truncated
+ * sequences fail. Under the compat and strict profiles a URL the profile
+ * accepts costs nothing extra; only one it rejects that has a byte from
+ * 0x80 is parsed again and validated. Under lenient, every accepted URL
+ * gets one vector scan for such bytes, and is validated if it has any.
+ *
+ * Arguments:
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   opts       - Profile, flags and CONNECT flag, or NULL for the defaults
+ *   u          - Pointer to http_parser_url structure to fill, must be initialized
+ *
+ * Returns:
+ *   0 on success, non-zero on failure or an unknown profile
+ */
+int llurl_parse_url_opts(const char *buf, size_t buflen,
+                         const struct llurl_parse_options *opts,
+                         struct http_parser_url *u);
+
+/* Initialize a 32-bit URL structure to zeros before parsing */
+void http_parser_url32_init(struct http_parser_url32 *u);
+
+/* Parse a URL into 32-bit offsets; return nonzero on failure
+ *
+ * Same parser and rules as http_parser_parse_url(); use it when buflen may
+ * exceed 65535. Offsets are exact for URLs up to 4 GB.
+ *
+ * Arguments:
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ *   u          - Pointer to http_parser_url32 structure to fill, must be initialized
+ *
+ * Returns:
+ *   0 on success, non-zero on failure
+ */
+int http_parser_parse_url32(const char *buf, size_t buflen,
+                            int is_connect,
+                            struct http_parser_url32 *u);
+
+/* Structure-of-arrays result for http_parser_parse_url_batch()
+ *
+ * Each member points to a caller-owned array with one entry per input URL,
+ * so a single field can be read for every URL without striding through
+ * struct http_parser_url. Any pointer may be NULL to skip that column.
+ *
+ * For URL k:
+ *   status[k]     - 0 on success, 1 on failure
+ *   field_set[k]  - Bitmask of (1 << UF_*) values, 0 on failure
+ *   port[k]       - Converted UF_PORT string, 0 if absent
+ *   off[UF_*][k]  - Offset of the field in bufs[k], 0 if absent
+ *   len[UF_*][k]  - Length of the field, 0 if absent
+ */
+struct http_parser_url_batch {
+  uint8_t *status;
+  uint16_t *field_set;
+  uint16_t *port;
+  uint16_t *off[UF_MAX];
+  uint16_t *len[UF_MAX];
+};
+
+/* Parse a batch of URLs in one call
+ *
+ * Equivalent to calling http_parser_url_init() and http_parser_parse_url()
+ * for each URL and copying the results into the requested columns. Only
+ * the output layout changes: each URL is still one parse, so a batch costs
+ * about what that loop does (make run-benchmark, "Batch API"). Use it when
+ * the consumer wants columns, and as the unit of work of
+ * llurl_pool_parse_batch().
+ *
+ * Arguments:
+ *   bufs       - Array of n URL strings
+ *   lens       - Array of n URL lengths
+ *   n          - Number of URLs
+ *   is_connect - Non-zero if these are CONNECT request targets
+ *   out        - Column arrays to fill, each with room for n entries
+ *
+ * Returns:
+ *   Number of URLs that failed to parse (0 if all succeeded)
+ */
+size_t http_parser_parse_url_batch(const char *const *bufs, const size_t *lens,
+                                   size_t n, int is_connect,
+                                   const struct http_parser_url_batch *out);
+
+/* Pool of parsing threads, kept parked between batches */
+struct llurl_pool;
+
+/* Start a pool of nthreads workers; NULL on failure
+ *
+ * The calling thread of llurl_pool_parse_batch() is one of the workers, so
+ * nthreads - 1 threads are started here and wait on a condition variable
+ * until a batch is posted. If fewer can be started the pool is created
+ * with the ones that were; llurl_pool_size() tells how many.
+ *
+ * Arguments:
+ *   nthreads - Number of workers, 0 for one per online CPU (at most 256)
+ */
+struct llurl_pool *llurl_pool_create(unsigned int nthreads);
+
+/* Stop a pool's threads and free it */
+void llurl_pool_destroy(struct llurl_pool *pool);
+
+/* Number of workers in a pool, the calling thread included */
+unsigned int llurl_pool_size(const struct llurl_pool *pool);
+
+/* Parse a batch of URLs on the workers of a pool
+ *
+ * Same contract and results as http_parser_parse_url_batch(). The batch is
+ * cut into fixed-size chunks that are split evenly between the workers
+ * (the calling thread is one of them); a worker that runs out of chunks
+ * steals from the others, so a few long URLs do not hold up the batch.
+ * Batches of one chunk are parsed on the calling thread. A pool runs one
+ * batch at a time: do not share it between calling threads.
+ *
+ * Arguments:
+ *   pool - Pool from llurl_pool_create()
+ *   bufs, lens, n, is_connect, out - As for http_parser_parse_url_batch()
+ *
+ * Returns:
+ *   Number of URLs that failed to parse (0 if all succeeded)
+ */
+size_t llurl_pool_parse_batch(struct llurl_pool *pool, const char *const *bufs,
+                              const size_t *lens, size_t n, int is_connect,
+                              const struct http_parser_url_batch *out);
+
+/* Parse one batch of URLs on threads started for this call
+ *
+ * As llurl_pool_parse_batch() on a pool created and destroyed around the
+ * call, so every call pays for starting and joining its threads (tens of
+ * microseconds per thread; see make bench-parallel). Use a pool when
+ * parsing batches repeatedly.
+ *
+ * Arguments:
+ *   bufs, lens, n, is_connect, out - As for http_parser_parse_url_batch()
+ *   nthreads   - Number of threads to use, 0 for one per online CPU
+ *
+ * Returns:
+ *   Number of URLs that failed to parse (0 if all succeeded)
+ */
+size_t llurl_parse_batch_parallel(const char *const *bufs, const size_t *lens,
+                                  size_t n, int is_connect,
+                                  const struct http_parser_url_batch *out,
+                                  unsigned int nthreads);
+
+/* Host interning table: maps host names to small, stable integer ids */
+struct llurl_intern;
+
+/* Longest name llurl_intern() accepts (a DNS name is at most 253 bytes) */
+#define LLURL_INTERN_NAME_MAX 255
+
+/* Create an interning table for up to capacity names; NULL on failure
+ *
+ * The table never grows: ids are assigned in insertion order from 0 to
+ * capacity - 1, and the hash buckets are sized once so that a full table
+ * is still at most 3/4 occupied.
+ */
+struct llurl_intern *llurl_intern_create(size_t capacity);
+
+/* Free a table and every name in it */
+void llurl_intern_destroy(struct llurl_intern *t);
+
+/* Id of a name, adding it if new; return nonzero on failure
+ *
+ * Names are compared ASCII case-insensitively and stored lower-cased, so
+ * "Example.COM" and "example.com" share one id. Looking up a name already
+ * in the table takes no lock and writes no shared memory, so any number
+ * of threads can call this on one table; adding a name takes a mutex.
+ *
+ * Arguments:
+ *   t    - Table
+ *   name - Name bytes, not NUL-terminated
+ *   len  - Length of name, at most LLURL_INTERN_NAME_MAX
+ *   id   - Receives the id
+ *
+ * Returns:
+ *   0 on success, non-zero if the name is too long, or is new and the
+ *   table is full or out of memory
+ */
+int llurl_intern(struct llurl_intern *t, const char *name, size_t len, uint32_t *id);
+
+/* Id of a name already in the table; return nonzero if it is not there
+ *
+ * The lock-free half of llurl_intern(): it never adds the name.
+ */
+int llurl_intern_find(const struct llurl_intern *t, const char *name, size_t len,
+                      uint32_t *id);
+
+/* Id of the UF_HOST field of a parsed URL, as llurl_intern(); return
+ * nonzero on failure, including when the URL has no host */
+int llurl_intern_url_host(struct llurl_intern *t, const char *buf,
+                          const struct http_parser_url *u, uint32_t *id);
+
+/* Lower-cased name of an id, valid until the table is destroyed; NULL if
+ * the id has not been assigned */
+const char *llurl_intern_name(const struct llurl_intern *t, uint32_t id, size_t *len);
+
+/* Number of names in the table */
+size_t llurl_intern_count(const struct llurl_intern *t);
+
+/* Parse-result cache for URLs that repeat, such as health checks and
+ * popular endpoints. A cache is not synchronized: give each thread its own */
+struct llurl_cache;
+
+/* Counters of a cache since it was created or last cleared */
+struct llurl_cache_stats {
+  uint64_t hits;            /* Results copied from the cache */
+  uint64_t misses;          /* URLs parsed and then cached */
+  uint64_t bypassed;        /* URLs longer than max_url_len, parsed only */
+};
+
+/* Create a cache; NULL on failure
+ *
+ * Arguments:
+ *   entries     - Number of results to keep, rounded up to a power of two;
+ *                 at most UINT32_MAX
+ *   max_url_len - Longest URL to cache (at most 65535); longer ones are
+ *                 parsed every time. The cache keeps a copy of each URL,
+ *                 entries * max_url_len bytes in all
+ */
+struct llurl_cache *llurl_cache_create(size_t entries, size_t max_url_len);
+
+/* Free a cache */
+void llurl_cache_destroy(struct llurl_cache *c);
+
+/* Parse a URL through a cache; return nonzero on failure
+ *
+ * Same return value and *u as http_parser_parse_url() on a freshly
+ * initialized structure, failures included. The cache is 4-way set
+ * associative, keyed by a hash of the URL bytes and is_connect; a hit is
+ * confirmed by comparing the bytes with a saved copy, and then copies the
+ * saved result without running the parser.
+ *
+ * Arguments:
+ *   c          - Cache
+ *   buf        - URL string to parse
+ *   buflen     - Length of the URL string
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ *   u          - Receives the result; need not be initialized
+ *
+ * Returns:
+ *   0 on success, non-zero on failure
+ */
+int llurl_cache_parse(struct llurl_cache *c, const char *buf, size_t buflen,
+                      int is_connect, struct http_parser_url *u);
+
+/* Read the counters of a cache */
+void llurl_cache_stats(const struct llurl_cache *c, struct llurl_cache_stats *stats);
+
+/* Drop every cached result and zero the counters */
+void llurl_cache_clear(struct llurl_cache *c);
+
+/* Longest authority (host[:port], after any userinfo) a streaming parse
+ * accepts. http_parser_parse_url() has no such limit, so a longer
+ * authority it accepts makes llurl_stream_feed() or llurl_stream_finish()
+ * fail; join the pieces and parse them in one call if such URLs matter */
+#define LLURL_STREAM_HOST_MAX 512
+
+/* Resumable parser for a URL that arrives in several pieces
+ *
+ * Feeding the pieces in order to llurl_stream_feed() and then calling
+ * llurl_stream_finish() gives the same result as one http_parser_parse_url()
+ * over the joined buffer, without joining it: every byte is examined once,
+ * and only the authority is copied (into host[]) so that host and port can
+ * be split when it ends. Offsets in the result are relative to the start
+ * of the joined URL.
+ *
+ * The members are private to the parser; initialize with llurl_stream_init().
+ */
+struct llurl_stream {
+  struct http_parser_url u; /* Result so far */
+  size_t pos;               /* Bytes consumed */
+  size_t field_start;
+  size_t port_start;
+  uint8_t state;
+  uint8_t field;
+  uint8_t found_colon;
+  int8_t bracket_depth;
+  uint8_t is_connect;
+  uint8_t flags;
+  uint16_t host_len;
+  char host[LLURL_STREAM_HOST_MAX];
+};
+
+/* Start a streaming parse
+ *
+ * Arguments:
+ *   s          - Parser to initialize
+ *   is_connect - Non-zero if this is a CONNECT request (expects authority form)
+ */
+void llurl_stream_init(struct llurl_stream *s, int is_connect);
+
+/* Feed the next piece of the URL; return nonzero once the URL is invalid
+ *
+ * A nonzero return means no continuation can make the URL valid; further
+ * calls keep returning nonzero. Empty pieces are allowed.
+ */
+int llurl_stream_feed(struct llurl_stream *s, const char *data, size_t len);
+
+/* End a streaming parse; return nonzero on failure
+ *
+ * On success *u holds the same result as http_parser_parse_url() over the
+ * joined pieces. Fails as that call would, and also if the authority was
+ * longer than LLURL_STREAM_HOST_MAX bytes. The parser must be initialized
+ * again before reuse.
+ */
+int llurl_stream_finish(struct llurl_stream *s, struct http_parser_url *u);
+
+/* Name of the batch scan kernel selected at load time
+ *
+ * The path/query/fragment and host scans use SSE4.2 or AVX2 when the CPU
+ * supports them. The choice is made once, from cpuid, when the library is
+ * loaded; setting the environment variable LLURL_ISA to "scalar", "sse42"
+ * or "avx2" caps it (a variant the CPU lacks is never selected).
+ *
+ * Returns:
+ *   "scalar", "sse42" or "avx2"
+ */
+const char *llurl_scan_isa(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,235 @@
+/* Copyright (c) 2024 llurl contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Parse-result cache.
+ *
+ * A 4-way set-associative cache from the raw URL bytes to the result of
+ * http_parser_parse_url(). A lookup hashes the URL, compares hash tags and
+ * lengths of the four ways of one set, all in one cache line, and confirms
+ * a match with a memcmp against the stored copy of the URL; a hit copies
+ * the saved result and never runs the parser. A miss replaces the least
+ * recently used way of the set.
+ *
+ * Four ways rather than two cost nothing on a hit, since the tags of a set
+ * share one cache line, and make it less likely that a few popular URLs
+ * landing in one set keep evicting each other.
+ *
+ * A cache belongs to one thread: nothing here is synchronized.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "llurl.h"
+#include "llurl_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================================
+ * CONSTANTS AND TYPE DEFINITIONS
+ * ============================================================================ */
+
+#define WAYS 4
+
+/* The lookup half of a set: one cache line */
+struct set {
+  uint32_t tag[WAYS];       /* high hash bits, 0 while the way is empty */
+  uint32_t stamp[WAYS];     /* c->clock at the last use */
+  uint16_t len[WAYS];
+  uint8_t flags[WAYS];      /* ENTRY_* */
+} ALIGNED_64;
+
+#define ENTRY_CONNECT 0x1   /* parsed with is_connect */
+#define ENTRY_FAILED 0x2    /* http_parser_parse_url() failed */
+
+struct llurl_cache {
+  struct set *sets;
+  struct http_parser_url *results; /* WAYS per set */
+  char *urls;               /* max_len bytes per way */
+  size_t mask;              /* set count - 1 */
+  size_t max_len;
+  uint32_t clock;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t bypassed;
+};
+
+/* ============================================================================
+ * HASHING
+ * ============================================================================ */
+
+/* Hash of the URL bytes. Two independent multiply chains, so that long
+ * URLs are not bound by the latency of one */
+static inline uint64_t hash_url(const char *p, size_t len) {
+  uint64_t h0 = HASH_K0 ^ len;
+  uint64_t h1 = 0xc2b2ae3d27d4eb4fULL;
+  size_t i = 0;
+  for (; i + 16 < len; i += 16) {
+    h0 = hash_step(h0, load8(p + i), HASH_K0);
+    h1 = hash_step(h1, load8(p + i + 8), HASH_K1);
+  }
+  if (i + 8 < len) {
+    h0 = hash_step(h0, load8(p + i), HASH_K0);
+  }
+  if (len > 0) {
+    h1 = hash_step(h1, tail_word(p, len), HASH_K1);
+  }
+  return hash_finish(h0 ^ h1 ^ (h1 >> 32));
+}
+
+/* Compare the URL with a stored copy of the same length, 8 bytes at a time */
+static inline int bytes_equal(const char *stored, const char *p, size_t len) {
+  size_t i = 0;
+  for (; i + 8 < len; i += 8) {
+    if (load8(stored + i) != load8(p + i)) {
+      return 0;
+    }
+  }
+  return len == 0 || tail_word(stored, len) == tail_word(p, len);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+/* Create a cache of about `entries` results for URLs up to max_url_len
+ * bytes; NULL on failure */
+struct llurl_cache *llurl_cache_create(size_t entries, size_t max_url_len) {
+  struct llurl_cache *c;
+  size_t nsets = 1;
+
+  if (entries == 0 || entries > UINT32_MAX || max_url_len == 0 || max_url_len > UINT16_MAX) {
+    return NULL;
+  }
+  while (nsets * WAYS < entries) {
+    nsets <<= 1;
+  }
+  /* Where size_t is 32 bits even a capped count can overflow the sizes */
+  if (nsets > SIZE_MAX / sizeof(struct set) ||
+      nsets > SIZE_MAX / WAYS / sizeof(struct http_parser_url) ||
+      nsets > SIZE_MAX / WAYS / max_url_len) {
+    return NULL;
+  }
+
+  c = calloc(1, sizeof(*c));
+  if (!c) {
+    return NULL;
+  }
+  if (posix_memalign((void **)&c->sets, 64, nsets * sizeof(struct set)) != 0) {
+    c->sets = NULL;
+  }
+  c->results = malloc(nsets * WAYS * sizeof(struct http_parser_url));
+  c->urls = malloc(nsets * WAYS * max_url_len);
+  if (!c->sets || !c->results || !c->urls) {
+    llurl_cache_destroy(c);
+    return NULL;
+  }
+  c->mask = nsets - 1;
+  c->max_len = max_url_len;
+  llurl_cache_clear(c);
+  return c;
+}
+
+/* Free a cache */
+void llurl_cache_destroy(struct llurl_cache *c) {
+  if (!c) {
+    return;
+  }
+  free(c->sets);
+  free(c->results);
+  free(c->urls);
+  free(c);
+}
+
+/* Parse a URL through the cache; return nonzero on failure */
+int llurl_cache_parse(struct llurl_cache *c, const char *buf, size_t buflen,
+                      int is_connect, struct http_parser_url *u) {
+  uint64_t h;
+  uint32_t tag;
+  struct set *set;
+  size_t s, slot;
+  unsigned int w, victim, match = 0;
+  uint8_t want = is_connect ? ENTRY_CONNECT : 0;
+  int rv;
+
+  if (buflen > c->max_len) {
+    c->bypassed++;
+    http_parser_url_init(u);
+    return http_parser_parse_url(buf, buflen, is_connect, u);
+  }
+
+  h = hash_url(buf, buflen);
+  tag = hash_tag(h);
+  s = (size_t)h & c->mask;
+  set = &c->sets[s];
+  c->clock++;
+  for (w = 0; w < WAYS; w++) {
+    match |= (unsigned int)(set->tag[w] == tag) << w;
+  }
+  while (match) {
+    w = (unsigned int)CTZ(match);
+    slot = s * WAYS + w;
+    if (LIKELY(set->len[w] == buflen && (set->flags[w] & ENTRY_CONNECT) == want &&
+               bytes_equal(c->urls + slot * c->max_len, buf, buflen))) {
+      c->hits++;
+      set->stamp[w] = c->clock;
+      *u = c->results[slot];
+      return (set->flags[w] & ENTRY_FAILED) != 0;
+    }
+    match &= match - 1;
+  }
+
+  /* Miss: parse, then replace an empty or the least recently used way */
+  c->misses++;
+  http_parser_url_init(u);
+  rv = http_parser_parse_url(buf, buflen, is_connect, u);
+  victim = 0;
+  for (w = 1; w < WAYS; w++) {
+    if (set->tag[victim] != 0 &&
+        (set->tag[w] == 0 || (uint32_t)(c->clock - set->stamp[w]) >
+                             (uint32_t)(c->clock - set->stamp[victim]))) {
+      victim = w;
+    }
+  }
+  slot = s * WAYS + victim;
+  set->tag[victim] = tag;
+  set->stamp[victim] = c->clock;
+  set->len[victim] = (uint16_t)buflen;
+  set->flags[victim] = (uint8_t)(want | (rv ? ENTRY_FAILED : 0));
+  c->results[slot] = *u;
+  memcpy(c->urls + slot * c->max_len, buf, buflen);
+  return rv;
+}
+
+/* Read the cache counters */
+void llurl_cache_stats(const struct llurl_cache *c, struct llurl_cache_stats *stats) {
+  stats->hits = c->hits;
+  stats->misses = c->misses;
+  stats->bypassed = c->bypassed;
+}
+
+/* Drop every entry and zero the counters */
+void llurl_cache_clear(struct llurl_cache *c) {
+  memset(c->sets, 0, (c->mask + 1) * sizeof(struct set));
+  c->clock = 0;
+  c->hits = 0;
+  c->misses = 0;
+  c->bypassed = 0;
+}
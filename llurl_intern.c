@@ -0,0 +1,348 @@
+/* Copyright (c) 2024 llurl contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Host interning table.
+ *
+ * Open addressing over 64-byte buckets of 8 slots. A slot holds a 32-bit
+ * tag (high hash bits, never 0) and the id of its name, so a lookup
+ * usually touches one bucket line and one name. Names are only ever added,
+ * which is what makes the read path lock-free: a writer fills in the name
+ * and the slot's id before publishing its tag with a release store, and a
+ * reader that sees the tag with an acquire load sees the rest. Writers
+ * serialize on a mutex.
+ *
+ * Kept out of llurl.c so that only callers of the table need pthreads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "llurl.h"
+#include "llurl_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(LLURL_HAVE_THREADS)
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define LOAD_ACQUIRE(p) (*(p))
+#define STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+
+/* SSE2 is part of x86-64, so no runtime dispatch is needed for it. Thread
+ * sanitizer builds use the scalar probe, whose atomic loads it can follow */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__) && \
+    !defined(__SANITIZE_THREAD__)
+#define LLURL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* ============================================================================
+ * CONSTANTS AND TYPE DEFINITIONS
+ * ============================================================================ */
+
+#define BUCKET_SLOTS 8
+
+/* One cache line: tags first, so a probe compares them before loading ids */
+struct bucket {
+  uint32_t tag[BUCKET_SLOTS];
+  uint32_t id[BUCKET_SLOTS];
+} ALIGNED_64;
+
+struct name {
+  const char *data;
+  size_t len;
+};
+
+struct llurl_intern {
+  struct bucket *buckets;
+  size_t mask;              /* bucket count - 1 */
+  struct name *names;       /* indexed by id */
+  size_t capacity;
+  size_t count;             /* published with a release store */
+#if defined(LLURL_HAVE_THREADS)
+  pthread_mutex_t lock;
+#endif
+};
+
+/* ============================================================================
+ * CASE FOLDING AND HASHING
+ * ============================================================================ */
+
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+/* Lower-case the ASCII letters of 8 bytes at once. For each byte, the
+ * high bit of (b & 0x7f) + k tells whether it is above 0x80 - k, so one
+ * add finds bytes >= 'A', another bytes > 'Z', and the difference moved
+ * down to bit 5 is the 0x20 to OR in */
+static inline uint64_t fold_word(uint64_t w) {
+  uint64_t low7 = w & ~HIGHS;
+  uint64_t ge_a = low7 + (0x80 - 'A') * ONES;
+  uint64_t gt_z = low7 + (0x7f - 'Z') * ONES;
+  uint64_t upper = (ge_a ^ gt_z) & ~w & HIGHS;
+  return w | (upper >> 2);
+}
+
+/* Hash of the case-folded name, 8 bytes per step */
+static inline uint64_t hash_name(const char *p, size_t len) {
+  uint64_t h = HASH_K0 ^ len;
+  size_t i = 0;
+  for (; i + 8 < len; i += 8) {
+    h = hash_step(h, fold_word(load8(p + i)), HASH_K0);
+  }
+  if (len > 0) {
+    h = hash_step(h, fold_word(tail_word(p, len)), HASH_K0);
+  }
+  return hash_finish(h);
+}
+
+/* Compare a name with a stored, already folded one of the same length */
+static inline int name_equals(const char *p, const char *stored, size_t len) {
+  size_t i = 0;
+  for (; i + 8 < len; i += 8) {
+    if (fold_word(load8(p + i)) != load8(stored + i)) {
+      return 0;
+    }
+  }
+  return len == 0 || fold_word(tail_word(p, len)) == tail_word(stored, len);
+}
+
+/* ============================================================================
+ * LOOKUP
+ * ============================================================================ */
+
+/* Masks of the slots of a bucket whose tag is tag, and of the empty ones.
+ *
+ * With SSE2 all 8 tags are compared in two 16-byte loads. Each tag is an
+ * aligned 4-byte lane of an aligned load, so it is read whole even while a
+ * writer publishes a neighbouring slot; the fence then orders the id and
+ * name loads after it, as an acquire load of the tag would. */
+static inline void bucket_masks(const struct bucket *bk, uint32_t tag, unsigned int *match,
+                                unsigned int *empty) {
+#if defined(LLURL_HAVE_SSE2)
+  __m128i want = _mm_set1_epi32((int)tag);
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_load_si128((const __m128i *)bk->tag);
+  __m128i hi = _mm_load_si128((const __m128i *)(bk->tag + 4));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  *match = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo, want))) |
+           ((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hi, want))) << 4);
+  *empty = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo, zero))) |
+           ((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hi, zero))) << 4);
+#else
+  unsigned int m = 0;
+  unsigned int e = 0;
+  for (unsigned int s = 0; s < BUCKET_SLOTS; s++) {
+    uint32_t slot_tag = LOAD_ACQUIRE(&bk->tag[s]);
+    m |= (unsigned int)(slot_tag == tag) << s;
+    e |= (unsigned int)(slot_tag == 0) << s;
+  }
+  *match = m;
+  *empty = e;
+#endif
+}
+
+/* Probe for a name; return 1 and its id if present. Otherwise return 0 and
+ * the first empty slot, which is where an insert under the lock goes.
+ * Slots fill in order, so nothing at or after the first empty slot counts */
+static int probe(const struct llurl_intern *t, const char *p, size_t len, uint64_t h,
+                 uint32_t *id, size_t *empty_bucket, unsigned int *empty_slot) {
+  uint32_t tag = hash_tag(h);
+  size_t b = (size_t)h & t->mask;
+
+  for (;;) {
+    const struct bucket *bk = &t->buckets[b];
+    unsigned int match, empty;
+    bucket_masks(bk, tag, &match, &empty);
+    if (empty) {
+      match &= (empty & (0u - empty)) - 1;
+    }
+    while (match) {
+      unsigned int s = (unsigned int)CTZ(match);
+      const struct name *n = &t->names[bk->id[s]];
+      if (LIKELY(n->len == len && name_equals(p, n->data, len))) {
+        *id = bk->id[s];
+        return 1;
+      }
+      match &= match - 1;
+    }
+    if (empty) {
+      *empty_bucket = b;
+      *empty_slot = (unsigned int)CTZ(empty);
+      return 0;
+    }
+    b = (b + 1) & t->mask;
+  }
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+/* Create a table for up to capacity names; NULL on failure */
+struct llurl_intern *llurl_intern_create(size_t capacity) {
+  struct llurl_intern *t;
+  size_t nbuckets = 1;
+
+  if (capacity == 0 || capacity > UINT32_MAX) {
+    return NULL;
+  }
+  /* At most 3/4 of the slots in use, so every probe meets an empty one */
+  while (nbuckets * BUCKET_SLOTS * 3 < capacity * 4) {
+    nbuckets <<= 1;
+  }
+
+  t = calloc(1, sizeof(*t));
+  if (!t) {
+    return NULL;
+  }
+  if (posix_memalign((void **)&t->buckets, 64, nbuckets * sizeof(struct bucket)) != 0) {
+    t->buckets = NULL;
+  }
+  t->names = calloc(capacity, sizeof(struct name));
+  if (!t->buckets || !t->names) {
+    free(t->buckets);
+    free(t->names);
+    free(t);
+    return NULL;
+  }
+#if defined(LLURL_HAVE_THREADS)
+  if (pthread_mutex_init(&t->lock, NULL) != 0) {
+    free(t->buckets);
+    free(t->names);
+    free(t);
+    return NULL;
+  }
+#endif
+  memset(t->buckets, 0, nbuckets * sizeof(struct bucket));
+  t->mask = nbuckets - 1;
+  t->capacity = capacity;
+  return t;
+}
+
+/* Free a table and its names */
+void llurl_intern_destroy(struct llurl_intern *t) {
+  if (!t) {
+    return;
+  }
+  for (size_t k = 0; k < t->count; k++) {
+    free((char *)t->names[k].data);
+  }
+#if defined(LLURL_HAVE_THREADS)
+  pthread_mutex_destroy(&t->lock);
+#endif
+  free(t->buckets);
+  free(t->names);
+  free(t);
+}
+
+/* Find a name without adding it; return nonzero if absent */
+int llurl_intern_find(const struct llurl_intern *t, const char *name, size_t len,
+                      uint32_t *id) {
+  size_t b;
+  unsigned int s;
+  if (len > LLURL_INTERN_NAME_MAX) {
+    return 1;
+  }
+  return !probe(t, name, len, hash_name(name, len), id, &b, &s);
+}
+
+/* Id of a name, adding it if new; return nonzero on failure */
+int llurl_intern(struct llurl_intern *t, const char *name, size_t len, uint32_t *id) {
+  uint64_t h;
+  size_t b;
+  unsigned int s;
+  char *copy;
+  uint32_t new_id;
+
+  if (len > LLURL_INTERN_NAME_MAX) {
+    return 1;
+  }
+  h = hash_name(name, len);
+  if (LIKELY(probe(t, name, len, h, id, &b, &s))) {
+    return 0;
+  }
+
+#if defined(LLURL_HAVE_THREADS)
+  pthread_mutex_lock(&t->lock);
+#endif
+  /* Another writer may have added it, or taken our empty slot */
+  if (probe(t, name, len, h, id, &b, &s)) {
+#if defined(LLURL_HAVE_THREADS)
+    pthread_mutex_unlock(&t->lock);
+#endif
+    return 0;
+  }
+  if (t->count == t->capacity || !(copy = malloc(len + 1))) {
+#if defined(LLURL_HAVE_THREADS)
+    pthread_mutex_unlock(&t->lock);
+#endif
+    return 1;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)name[i];
+    copy[i] = (char)(c >= 'A' && c <= 'Z' ? c + 32 : c);
+  }
+  copy[len] = '\0';
+
+  new_id = (uint32_t)t->count;
+  t->names[new_id].data = copy;
+  t->names[new_id].len = len;
+  t->buckets[b].id[s] = new_id;
+  STORE_RELEASE(&t->buckets[b].tag[s], hash_tag(h));
+  STORE_RELEASE(&t->count, t->count + 1);
+#if defined(LLURL_HAVE_THREADS)
+  pthread_mutex_unlock(&t->lock);
+#endif
+  *id = new_id;
+  return 0;
+}
+
+/* Intern the host of a parsed URL; return nonzero on failure */
+int llurl_intern_url_host(struct llurl_intern *t, const char *buf,
+                          const struct http_parser_url *u, uint32_t *id) {
+  if (!(u->field_set & (1 << UF_HOST))) {
+    return 1;
+  }
+  return llurl_intern(t, buf + u->field_data[UF_HOST].off, u->field_data[UF_HOST].len, id);
+}
+
+/* Name of an assigned id; NULL otherwise */
+const char *llurl_intern_name(const struct llurl_intern *t, uint32_t id, size_t *len) {
+  if (id >= LOAD_ACQUIRE(&t->count)) {
+    return NULL;
+  }
+  if (len) {
+    *len = t->names[id].len;
+  }
+  return t->names[id].data;
+}
+
+/* Number of names in the table */
+size_t llurl_intern_count(const struct llurl_intern *t) {
+  return LOAD_ACQUIRE(&t->count);
+}
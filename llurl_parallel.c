@@ -0,0 +1,385 @@
+/* Copyright (c) 2024 llurl contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Multi-threaded batch parsing on top of http_parser_parse_url_batch().
+ *
+ * A pool keeps its threads parked on a condition variable between batches,
+ * so a batch costs one broadcast and one wait rather than a create and a
+ * join per thread. llurl_parse_batch_parallel() is the one-off form: it
+ * builds a pool for a single batch and tears it down again.
+ *
+ * Kept out of llurl.c so that only callers of the pool need pthreads.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "llurl.h"
+#include "llurl_util.h"
+#include <stdlib.h>
+
+/* Work stealing also needs the __atomic builtins */
+#if defined(LLURL_HAVE_THREADS) && !defined(__GNUC__) && !defined(__clang__)
+#undef LLURL_HAVE_THREADS
+#endif
+
+#if defined(LLURL_HAVE_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(LLURL_HAVE_THREADS)
+
+/* ============================================================================
+ * CONSTANTS AND TYPE DEFINITIONS
+ * ============================================================================ */
+
+/* URLs per chunk. A multiple of 64 so that chunk boundaries in every column
+ * (1-byte status, 2-byte fields) fall on cache-line multiples, and small
+ * enough that one chunk's URLs and outputs stay in L1/L2 */
+#define CHUNK_URLS 256
+
+/* Upper bound on workers, including the calling thread */
+#define MAX_WORKERS 256
+
+/* Per-worker queue: a contiguous range of chunks [next, end). The owner and
+ * thieves both claim chunks with an atomic fetch-add on `next`, so the owner
+ * walks its range in order and an idle worker can take whatever is left.
+ * Aligned to a cache line so that cursors of different workers never share
+ * one. */
+struct worker {
+  size_t next;
+  size_t end;
+  size_t failed;
+  unsigned int id;
+  struct parallel_job *job;
+  struct llurl_pool *pool;
+} ALIGNED_64;
+
+struct parallel_job {
+  const char *const *bufs;
+  const size_t *lens;
+  size_t n;
+  int is_connect;
+  const struct http_parser_url_batch *out;
+  unsigned int nworkers;
+  struct worker *workers;
+};
+#endif /* LLURL_HAVE_THREADS */
+
+struct llurl_pool {
+  unsigned int nworkers;    /* including the calling thread */
+#if defined(LLURL_HAVE_THREADS)
+  struct worker *workers;   /* nworkers, worker 0 is the caller */
+  pthread_t *threads;       /* nworkers - 1 */
+  pthread_mutex_t lock;
+  pthread_cond_t wake;      /* a batch was posted, or shutdown */
+  pthread_cond_t idle;      /* the last busy worker finished */
+  unsigned long generation; /* batches posted so far, under lock */
+  unsigned int active;      /* workers in the current batch, under lock */
+  unsigned int busy;        /* workers still on the batch, under lock */
+  int shutdown;
+#endif
+};
+
+#if defined(LLURL_HAVE_THREADS)
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/* Number of online CPUs, at least 1 */
+static unsigned int online_cpus(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (unsigned int)n : 1;
+#else
+  return 1;
+#endif
+}
+
+/* Parse one chunk into the caller's columns, shifted to the chunk start */
+static size_t parse_chunk(const struct parallel_job *job, size_t chunk) {
+  size_t base = chunk * CHUNK_URLS;
+  size_t count = job->n - base < CHUNK_URLS ? job->n - base : CHUNK_URLS;
+  const struct http_parser_url_batch *out = job->out;
+  struct http_parser_url_batch cols;
+
+  cols.status = out->status ? out->status + base : NULL;
+  cols.field_set = out->field_set ? out->field_set + base : NULL;
+  cols.port = out->port ? out->port + base : NULL;
+  for (int f = 0; f < UF_MAX; f++) {
+    cols.off[f] = out->off[f] ? out->off[f] + base : NULL;
+    cols.len[f] = out->len[f] ? out->len[f] + base : NULL;
+  }
+  return http_parser_parse_url_batch(job->bufs + base, job->lens + base,
+                                     count, job->is_connect, &cols);
+}
+
+/* Claim the next chunk of worker w, or return 0 if its range is drained */
+static int claim_chunk(struct worker *w, size_t *chunk) {
+  size_t c;
+  if (__atomic_load_n(&w->next, __ATOMIC_RELAXED) >= w->end) {
+    return 0;
+  }
+  c = __atomic_fetch_add(&w->next, 1, __ATOMIC_RELAXED);
+  if (c >= w->end) {
+    return 0;
+  }
+  *chunk = c;
+  return 1;
+}
+
+/* Drain our own range, then steal from the others until all are empty */
+static void run_worker(struct worker *self) {
+  struct parallel_job *job = self->job;
+  size_t chunk;
+  size_t failed = 0;
+
+  while (claim_chunk(self, &chunk)) {
+    failed += parse_chunk(job, chunk);
+  }
+  for (unsigned int k = 1; k < job->nworkers; k++) {
+    struct worker *victim = &job->workers[(self->id + k) % job->nworkers];
+    while (claim_chunk(victim, &chunk)) {
+      failed += parse_chunk(job, chunk);
+    }
+  }
+  self->failed = failed;
+}
+
+/* Pool thread: sleep until a batch is posted, take part in it if the batch
+ * has a range for us, and report back when done */
+static void *pool_main(void *arg) {
+  struct worker *self = arg;
+  struct llurl_pool *pool = self->pool;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (pool->generation == seen && !pool->shutdown) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    if (pool->shutdown) {
+      break;
+    }
+    seen = pool->generation;
+    if (self->id >= pool->active) {
+      continue;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    run_worker(self);
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0) {
+      pthread_cond_signal(&pool->idle);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/* Stop and join the first `started` pool threads */
+static void stop_threads(struct llurl_pool *pool, unsigned int started) {
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (unsigned int t = 0; t < started; t++) {
+    pthread_join(pool->threads[t], NULL);
+  }
+}
+#endif /* LLURL_HAVE_THREADS */
+
+/* ============================================================================
+ * THREAD POOL
+ * ============================================================================ */
+
+/* Start a pool of nthreads workers, the caller included; NULL on failure */
+struct llurl_pool *llurl_pool_create(unsigned int nthreads) {
+  struct llurl_pool *pool = calloc(1, sizeof(*pool));
+  if (!pool) {
+    return NULL;
+  }
+#if defined(LLURL_HAVE_THREADS)
+  if (nthreads == 0) {
+    nthreads = online_cpus();
+  }
+  if (nthreads > MAX_WORKERS) {
+    nthreads = MAX_WORKERS;
+  }
+  pool->nworkers = nthreads;
+  pool->threads = malloc(nthreads * sizeof(pthread_t));
+  if (!pool->threads ||
+      posix_memalign((void **)&pool->workers, 64, nthreads * sizeof(struct worker)) != 0) {
+    free(pool->threads);
+    free(pool);
+    return NULL;
+  }
+  if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+    goto fail_lock;
+  }
+  if (pthread_cond_init(&pool->wake, NULL) != 0) {
+    goto fail_wake;
+  }
+  if (pthread_cond_init(&pool->idle, NULL) != 0) {
+    goto fail_idle;
+  }
+
+  /* If a thread cannot be started the pool is created with the ones that
+   * did, so every range of a batch has a worker to drain it */
+  for (unsigned int w = 0; w < nthreads; w++) {
+    pool->workers[w].id = w;
+    pool->workers[w].pool = pool;
+  }
+  for (unsigned int w = 1; w < nthreads; w++) {
+    if (pthread_create(&pool->threads[w - 1], NULL, pool_main, &pool->workers[w]) != 0) {
+      pool->nworkers = w;
+      break;
+    }
+  }
+#else
+  (void)nthreads;
+  pool->nworkers = 1;
+#endif
+  return pool;
+
+#if defined(LLURL_HAVE_THREADS)
+fail_idle:
+  pthread_cond_destroy(&pool->wake);
+fail_wake:
+  pthread_mutex_destroy(&pool->lock);
+fail_lock:
+  free(pool->workers);
+  free(pool->threads);
+  free(pool);
+  return NULL;
+#endif
+}
+
+/* Stop the pool's threads and free it */
+void llurl_pool_destroy(struct llurl_pool *pool) {
+  if (!pool) {
+    return;
+  }
+#if defined(LLURL_HAVE_THREADS)
+  stop_threads(pool, pool->nworkers - 1);
+  pthread_cond_destroy(&pool->idle);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool->threads);
+#endif
+  free(pool);
+}
+
+/* Number of workers in a pool, the caller included */
+unsigned int llurl_pool_size(const struct llurl_pool *pool) {
+  return pool->nworkers;
+}
+
+/* ============================================================================
+ * PARALLEL BATCH PARSING
+ * ============================================================================ */
+
+/* Parse n URLs on the pool's workers; return the failure count */
+size_t llurl_pool_parse_batch(struct llurl_pool *pool, const char *const *bufs,
+                              const size_t *lens, size_t n, int is_connect,
+                              const struct http_parser_url_batch *out) {
+#if defined(LLURL_HAVE_THREADS)
+  size_t nchunks = (n + CHUNK_URLS - 1) / CHUNK_URLS;
+  unsigned int nworkers = pool->nworkers;
+  struct parallel_job job;
+  size_t failed = 0;
+
+  if (nworkers > nchunks) {
+    nworkers = (unsigned int)nchunks;
+  }
+  if (nworkers <= 1) {
+    return http_parser_parse_url_batch(bufs, lens, n, is_connect, out);
+  }
+
+  job.bufs = bufs;
+  job.lens = lens;
+  job.n = n;
+  job.is_connect = is_connect;
+  job.out = out;
+  job.nworkers = nworkers;
+  job.workers = pool->workers;
+
+  /* Even split of chunks; stealing evens out slow (e.g. 8KB) URLs */
+  for (unsigned int w = 0; w < nworkers; w++) {
+    struct worker *wk = &pool->workers[w];
+    wk->next = nchunks * w / nworkers;
+    wk->end = nchunks * (w + 1) / nworkers;
+    wk->failed = 0;
+    wk->job = &job;
+  }
+
+  /* The calling thread is worker 0 */
+  pthread_mutex_lock(&pool->lock);
+  pool->active = nworkers;
+  pool->busy = nworkers - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  run_worker(&pool->workers[0]);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy > 0) {
+    pthread_cond_wait(&pool->idle, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  for (unsigned int w = 0; w < nworkers; w++) {
+    failed += pool->workers[w].failed;
+  }
+  return failed;
+#else
+  (void)pool;
+  return http_parser_parse_url_batch(bufs, lens, n, is_connect, out);
+#endif
+}
+
+/* Parse n URLs on a pool built for this call alone */
+size_t llurl_parse_batch_parallel(const char *const *bufs, const size_t *lens,
+                                  size_t n, int is_connect,
+                                  const struct http_parser_url_batch *out,
+                                  unsigned int nthreads) {
+#if defined(LLURL_HAVE_THREADS)
+  size_t nchunks = (n + CHUNK_URLS - 1) / CHUNK_URLS;
+  struct llurl_pool *pool;
+
+  /* No point starting threads that would find no chunk to take */
+  if (nthreads == 0) {
+    nthreads = online_cpus();
+  }
+  if (nthreads > nchunks) {
+    nthreads = (unsigned int)nchunks;
+  }
+  if (nthreads > 1 && (pool = llurl_pool_create(nthreads)) != NULL) {
+    size_t failed = llurl_pool_parse_batch(pool, bufs, lens, n, is_connect, out);
+    llurl_pool_destroy(pool);
+    return failed;
+  }
+#endif
+  (void)nthreads;
+  return http_parser_parse_url_batch(bufs, lens, n, is_connect, out);
+}
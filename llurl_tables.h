@@ -0,0 +1,464 @@
+/* Generated by tools/gen_tables from tools/url_tables.spec by `make tables`.
+ * Do not edit; change the spec and regenerate. Included by llurl.c after
+ * enum state and STAY are defined. */
+
+#ifndef LLURL_TABLES_H
+#define LLURL_TABLES_H
+
+/* char_flags[byte] bits */
+#define CHAR_ALPHA       0x01  /* a-z, A-Z */
+#define CHAR_DIGIT       0x02  /* 0-9 */
+#define CHAR_HEX         0x04  /* 0-9, a-f, A-F */
+#define CHAR_UNRESERVED  0x08  /* - . _ ~ */
+#define CHAR_SUBDELIM    0x10  /* ! $ & ' ( ) * + , ; = */
+#define CHAR_USERINFO    0x20  /* Characters valid in userinfo */
+#define CHAR_QUERY       0x40  /* Valid in a query, except the & = # delimiters */
+
+static const unsigned char char_flags[256] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x70,0x00,0x00,0x70,0x60,0x30,0x70,0x70,0x70,0x70,0x70,0x70,0x68,0x68,0x40, /*  !"#$%&'()*+,-./ */
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x60,0x70,0x00,0x30,0x00,0x40, /* 0123456789:;<=>? */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* @ABCDEFGHIJKLMNO */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x00,0x40,0x00,0x68, /* PQRSTUVWXYZ[\]^_ */
+  0x00,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* `abcdefghijklmno */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x40,0x40,0x48,0x00, /* pqrstuvwxyz{|}~. */
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+/* Byte equivalence classes; class 0 is the bytes outside `valid`
+ *    0  " < > \ ^ `, 162 other bytes
+ *    1  ! #-* , / ; = ? @ [ ] _ {-~
+ *    2  + - . 0-9 A-Z a-z
+ *    3  :
+ */
+static const unsigned char url_class_table[256] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,1,0,1,1,1,1,1,1,1,1,2,1,2,2,1, /*  !"#$%&'()*+,-./ */
+  2,2,2,2,2,2,2,2,2,2,3,1,0,1,0,1, /* 0123456789:;<=>? */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* @ABCDEFGHIJKLMNO */
+  2,2,2,2,2,2,2,2,2,2,2,1,0,1,0,1, /* PQRSTUVWXYZ[\]^_ */
+  0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* `abcdefghijklmno */
+  2,2,2,2,2,2,2,2,2,2,2,1,1,1,1,0, /* pqrstuvwxyz{|}~. */
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+/* s_schema: next state for each byte, s_dead on error */
+static const unsigned char url_next_s_schema[256] = {
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead, /*  !"#$%&' */
+  s_dead,s_dead,s_dead,STAY,s_dead,STAY,STAY,s_dead, /* ()*+,-./ */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* 01234567 */
+  STAY,STAY,s_schema_slash,s_dead,s_dead,s_dead,s_dead,s_dead, /* 89:;<=>? */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* @ABCDEFG */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* HIJKLMNO */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* PQRSTUVW */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* XYZ[\]^_ */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* `abcdefg */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* hijklmno */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* pqrstuvw */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* xyz{|}~. */
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead
+};
+
+/* ----------------------------------------------------------------------------
+ * Profile strict
+ * ------------------------------------------------------------------------- */
+
+static const unsigned char char_flags_strict[256] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x70,0x00,0x00,0x70,0x60,0x30,0x70,0x70,0x70,0x70,0x70,0x70,0x68,0x68,0x40, /*  !"#$%&'()*+,-./ */
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x60,0x70,0x00,0x30,0x00,0x40, /* 0123456789:;<=>? */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* @ABCDEFGHIJKLMNO */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x00,0x40,0x00,0x68, /* PQRSTUVWXYZ[\]^_ */
+  0x00,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* `abcdefghijklmno */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x00,0x00,0x00,0x68,0x00, /* pqrstuvwxyz{|}~. */
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+/* Byte equivalence classes; class 0 is the bytes outside `valid`
+ *    0  " < > \ ^ ` {-}, 162 other bytes
+ *    1  ! #-* , / ; = ? @ [ ] _ ~
+ *    2  + - . 0-9 A-Z a-z
+ *    3  :
+ */
+static const unsigned char url_class_table_strict[256] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,1,0,1,1,1,1,1,1,1,1,2,1,2,2,1, /*  !"#$%&'()*+,-./ */
+  2,2,2,2,2,2,2,2,2,2,3,1,0,1,0,1, /* 0123456789:;<=>? */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* @ABCDEFGHIJKLMNO */
+  2,2,2,2,2,2,2,2,2,2,2,1,0,1,0,1, /* PQRSTUVWXYZ[\]^_ */
+  0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* `abcdefghijklmno */
+  2,2,2,2,2,2,2,2,2,2,2,0,0,0,1,0, /* pqrstuvwxyz{|}~. */
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
+/* s_schema: next state for each byte, s_dead on error */
+static const unsigned char url_next_s_schema_strict[256] = {
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead, /*  !"#$%&' */
+  s_dead,s_dead,s_dead,STAY,s_dead,STAY,STAY,s_dead, /* ()*+,-./ */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* 01234567 */
+  STAY,STAY,s_schema_slash,s_dead,s_dead,s_dead,s_dead,s_dead, /* 89:;<=>? */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* @ABCDEFG */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* HIJKLMNO */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* PQRSTUVW */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* XYZ[\]^_ */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* `abcdefg */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* hijklmno */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* pqrstuvw */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* xyz{|}~. */
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead
+};
+
+/* ----------------------------------------------------------------------------
+ * Profile lenient
+ * ------------------------------------------------------------------------- */
+
+static const unsigned char char_flags_lenient[256] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x40,0x70,0x40,0x00,0x70,0x60,0x30,0x70,0x70,0x70,0x70,0x70,0x70,0x68,0x68,0x40, /*  !"#$%&'()*+,-./ */
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x60,0x70,0x40,0x30,0x40,0x40, /* 0123456789:;<=>? */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* @ABCDEFGHIJKLMNO */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x40,0x40,0x40,0x68, /* PQRSTUVWXYZ[\]^_ */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* `abcdefghijklmno */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x40,0x40,0x68,0x00, /* pqrstuvwxyz{|}~. */
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,
+  0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60
+};
+
+/* Byte equivalence classes; class 0 is the bytes outside `valid`
+ *    0  33 other bytes
+ *    1  !-* , / ;-@ [-` {-~, 129 other bytes
+ *    2  + - . 0-9 A-Z a-z
+ *    3  :
+ */
+static const unsigned char url_class_table_lenient[256] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  1,1,1,1,1,1,1,1,1,1,1,2,1,2,2,1, /*  !"#$%&'()*+,-./ */
+  2,2,2,2,2,2,2,2,2,2,3,1,1,1,1,1, /* 0123456789:;<=>? */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* @ABCDEFGHIJKLMNO */
+  2,2,2,2,2,2,2,2,2,2,2,1,1,1,1,1, /* PQRSTUVWXYZ[\]^_ */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* `abcdefghijklmno */
+  2,2,2,2,2,2,2,2,2,2,2,1,1,1,1,0, /* pqrstuvwxyz{|}~. */
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+};
+
+/* s_schema: next state for each byte, s_dead on error */
+static const unsigned char url_next_s_schema_lenient[256] = {
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead, /*  !"#$%&' */
+  s_dead,s_dead,s_dead,STAY,s_dead,STAY,STAY,s_dead, /* ()*+,-./ */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* 01234567 */
+  STAY,STAY,s_schema_slash,s_dead,s_dead,s_dead,s_dead,s_dead, /* 89:;<=>? */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* @ABCDEFG */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* HIJKLMNO */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* PQRSTUVW */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* XYZ[\]^_ */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* `abcdefg */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* hijklmno */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* pqrstuvw */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* xyz{|}~. */
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead
+};
+
+/* ----------------------------------------------------------------------------
+ * Profile utf8
+ * ------------------------------------------------------------------------- */
+
+static const unsigned char char_flags_utf8[256] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x70,0x00,0x00,0x70,0x60,0x30,0x70,0x70,0x70,0x70,0x70,0x70,0x68,0x68,0x40, /*  !"#$%&'()*+,-./ */
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x60,0x70,0x00,0x30,0x00,0x40, /* 0123456789:;<=>? */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* @ABCDEFGHIJKLMNO */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x00,0x40,0x00,0x68, /* PQRSTUVWXYZ[\]^_ */
+  0x00,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* `abcdefghijklmno */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x40,0x40,0x48,0x00, /* pqrstuvwxyz{|}~. */
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40
+};
+
+/* Byte equivalence classes; class 0 is the bytes outside `valid`
+ *    0  " < > \ ^ `, 34 other bytes
+ *    1  ! #-* , / ; = ? @ [ ] _ {-~, 128 other bytes
+ *    2  + - . 0-9 A-Z a-z
+ *    3  :
+ */
+static const unsigned char url_class_table_utf8[256] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,1,0,1,1,1,1,1,1,1,1,2,1,2,2,1, /*  !"#$%&'()*+,-./ */
+  2,2,2,2,2,2,2,2,2,2,3,1,0,1,0,1, /* 0123456789:;<=>? */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* @ABCDEFGHIJKLMNO */
+  2,2,2,2,2,2,2,2,2,2,2,1,0,1,0,1, /* PQRSTUVWXYZ[\]^_ */
+  0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* `abcdefghijklmno */
+  2,2,2,2,2,2,2,2,2,2,2,1,1,1,1,0, /* pqrstuvwxyz{|}~. */
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+};
+
+/* s_schema: next state for each byte, s_dead on error */
+static const unsigned char url_next_s_schema_utf8[256] = {
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead, /*  !"#$%&' */
+  s_dead,s_dead,s_dead,STAY,s_dead,STAY,STAY,s_dead, /* ()*+,-./ */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* 01234567 */
+  STAY,STAY,s_schema_slash,s_dead,s_dead,s_dead,s_dead,s_dead, /* 89:;<=>? */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* @ABCDEFG */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* HIJKLMNO */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* PQRSTUVW */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* XYZ[\]^_ */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* `abcdefg */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* hijklmno */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* pqrstuvw */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* xyz{|}~. */
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead
+};
+
+/* ----------------------------------------------------------------------------
+ * Profile strict_utf8
+ * ------------------------------------------------------------------------- */
+
+static const unsigned char char_flags_strict_utf8[256] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x70,0x00,0x00,0x70,0x60,0x30,0x70,0x70,0x70,0x70,0x70,0x70,0x68,0x68,0x40, /*  !"#$%&'()*+,-./ */
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x60,0x70,0x00,0x30,0x00,0x40, /* 0123456789:;<=>? */
+  0x40,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* @ABCDEFGHIJKLMNO */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x40,0x00,0x40,0x00,0x68, /* PQRSTUVWXYZ[\]^_ */
+  0x00,0x65,0x65,0x65,0x65,0x65,0x65,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61, /* `abcdefghijklmno */
+  0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x61,0x00,0x00,0x00,0x68,0x00, /* pqrstuvwxyz{|}~. */
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,
+  0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40
+};
+
+/* Byte equivalence classes; class 0 is the bytes outside `valid`
+ *    0  " < > \ ^ ` {-}, 34 other bytes
+ *    1  ! #-* , / ; = ? @ [ ] _ ~, 128 other bytes
+ *    2  + - . 0-9 A-Z a-z
+ *    3  :
+ */
+static const unsigned char url_class_table_strict_utf8[256] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,1,0,1,1,1,1,1,1,1,1,2,1,2,2,1, /*  !"#$%&'()*+,-./ */
+  2,2,2,2,2,2,2,2,2,2,3,1,0,1,0,1, /* 0123456789:;<=>? */
+  1,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* @ABCDEFGHIJKLMNO */
+  2,2,2,2,2,2,2,2,2,2,2,1,0,1,0,1, /* PQRSTUVWXYZ[\]^_ */
+  0,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, /* `abcdefghijklmno */
+  2,2,2,2,2,2,2,2,2,2,2,0,0,0,1,0, /* pqrstuvwxyz{|}~. */
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+};
+
+/* s_schema: next state for each byte, s_dead on error */
+static const unsigned char url_next_s_schema_strict_utf8[256] = {
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead, /*  !"#$%&' */
+  s_dead,s_dead,s_dead,STAY,s_dead,STAY,STAY,s_dead, /* ()*+,-./ */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* 01234567 */
+  STAY,STAY,s_schema_slash,s_dead,s_dead,s_dead,s_dead,s_dead, /* 89:;<=>? */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* @ABCDEFG */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* HIJKLMNO */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* PQRSTUVW */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* XYZ[\]^_ */
+  s_dead,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* `abcdefg */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* hijklmno */
+  STAY,STAY,STAY,STAY,STAY,STAY,STAY,STAY, /* pqrstuvw */
+  STAY,STAY,STAY,s_dead,s_dead,s_dead,s_dead,s_dead, /* xyz{|}~. */
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,
+  s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead,s_dead
+};
+
+/* Table sets: the default, then one per profile in the spec */
+enum url_table_set {
+  URL_TABLES_DEFAULT,
+  URL_TABLES_STRICT,
+  URL_TABLES_LENIENT,
+  URL_TABLES_UTF8,
+  URL_TABLES_STRICT_UTF8,
+  URL_NUM_TABLE_SETS
+};
+
+struct url_tables {
+  const unsigned char *flags; /* char_flags */
+  const unsigned char *next_s_schema;
+};
+
+static const struct url_tables url_tables[URL_NUM_TABLE_SETS] = {
+  [URL_TABLES_DEFAULT] = { char_flags, url_next_s_schema },
+  [URL_TABLES_STRICT] = { char_flags_strict, url_next_s_schema_strict },
+  [URL_TABLES_LENIENT] = { char_flags_lenient, url_next_s_schema_lenient },
+  [URL_TABLES_UTF8] = { char_flags_utf8, url_next_s_schema_utf8 },
+  [URL_TABLES_STRICT_UTF8] = { char_flags_strict_utf8, url_next_s_schema_strict_utf8 },
+};
+
+/* X(set, suffix) for each table set, for static per-set data */
+#define URL_TABLE_SETS(X) \
+  X(URL_TABLES_DEFAULT, ) \
+  X(URL_TABLES_STRICT, _strict) \
+  X(URL_TABLES_LENIENT, _lenient) \
+  X(URL_TABLES_UTF8, _utf8) \
+  X(URL_TABLES_STRICT_UTF8, _strict_utf8)
+
+#endif /* LLURL_TABLES_H */
@@ -0,0 +1,115 @@
+/* Copyright (c) 2024 llurl contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Internal helpers shared by llurl_intern.c, llurl_cache.c and
+ * llurl_parallel.c: thread detection, branch hints, alignment, bit scans,
+ * and the word loads, mixing steps and tags both hashes are built from. Not installed; callers only ever see
+ * llurl.h. */
+
+#ifndef LLURL_UTIL_H
+#define LLURL_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* pthreads, decided by whether the header exists rather than by compiler:
+ * MinGW is GCC but has pthread.h only with winpthreads */
+#if defined(__has_include)
+#if __has_include(<pthread.h>)
+#define LLURL_HAVE_THREADS 1
+#endif
+#elif defined(__unix__) || defined(__APPLE__)
+#define LLURL_HAVE_THREADS 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define CTZ(x) __builtin_ctz(x)
+#define ALIGNED_64 __attribute__((aligned(64)))
+#else
+#define LIKELY(x) (x)
+#define ALIGNED_64
+static inline int CTZ(unsigned int x) {
+  int n = 0;
+  while (!(x & 1)) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
+static inline uint64_t load8(const char *p) {
+  uint64_t w;
+  memcpy(&w, p, 8);
+  return w;
+}
+
+static inline uint64_t load4(const char *p) {
+  uint32_t w;
+  memcpy(&w, p, 4);
+  return w;
+}
+
+/* The last 1-8 bytes of p[0 .. len), len >= 1, in one word without a
+ * variable-length copy: from 8 bytes on, the 8 bytes ending at len (which
+ * may overlap bytes already read); below that, two overlapping 4-byte
+ * loads, or the first, middle and last byte */
+static inline uint64_t tail_word(const char *p, size_t len) {
+  if (len >= 8) {
+    return load8(p + len - 8);
+  }
+  if (len >= 4) {
+    return load4(p) | (load4(p + len - 4) << 32);
+  }
+  return (uint64_t)(unsigned char)p[0] | ((uint64_t)(unsigned char)p[len >> 1] << 8) |
+         ((uint64_t)(unsigned char)p[len - 1] << 16);
+}
+
+/* Multipliers of the hash chains (the golden ratio and a MurmurHash3 one) */
+#define HASH_K0 0x9e3779b97f4a7c15ULL
+#define HASH_K1 0xd6e8feb86659fd93ULL
+
+/* One step of a multiply chain: fold in a word, then bring the high bits
+ * down so the next multiply spreads them */
+static inline uint64_t hash_step(uint64_t h, uint64_t w, uint64_t k) {
+  h = (h ^ w) * k;
+  return h ^ (h >> 29);
+}
+
+/* MurmurHash3 finalizer, so every input bit reaches both the low bits
+ * used as an index and the high bits used as a tag */
+static inline uint64_t hash_finish(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/* Tag stored in a slot: the high hash bits, with 0 kept for empty slots */
+static inline uint32_t hash_tag(uint64_t h) {
+  return (uint32_t)(h >> 32) | 1;
+}
+
+#endif /* LLURL_UTIL_H */
@@ -0,0 +1,358 @@
+/* Benchmark regression comparator
+ *
+ * Reads two result files written by `benchmark --json=FILE` or
+ * `benchmark --csv=FILE` (base first, then the candidate), and for every
+ * case in both compares the per-run ns/op samples with a two-sided
+ * Mann-Whitney U test. A case is flagged when the difference is
+ * significant at the chosen level and the median moved by more than the
+ * threshold; either alone is noise or a change too small to care about.
+ *
+ * The test makes no assumption about the shape of the timing distribution
+ * (which has a long right tail), only that runs are independent. The p
+ * value is exact for up to 20 runs a side without ties, and from the
+ * normal approximation with tie correction otherwise. Five runs a side is
+ * the least that can reach p < 0.01.
+ *
+ * Usage: bench_compare [-a alpha] [-t threshold%] base.json new.json
+ *
+ * Exits 1 if any case regressed, 0 otherwise, 2 on bad input.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_CASES 64
+#define MAX_RUNS 100
+#define EXACT_MAX 20
+
+struct bench_case {
+  char name[96];
+  double samples[MAX_RUNS];
+  int n;
+};
+
+struct result_file {
+  char sha[64];
+  struct bench_case cases[MAX_CASES];
+  int ncases;
+};
+
+/* ============================================================================
+ * READING RESULTS
+ * ============================================================================ */
+
+static char *read_file(const char *path) {
+  FILE *f = fopen(path, "rb");
+  char *data;
+  long size;
+
+  if (!f) {
+    perror(path);
+    return NULL;
+  }
+  if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+    perror(path);
+    fclose(f);
+    return NULL;
+  }
+  data = malloc((size_t)size + 1);
+  if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  if (data) {
+    data[size] = '\0';
+  }
+  return data;
+}
+
+/* Copy a JSON string starting after its opening quote; return the byte
+ * after the closing quote */
+static const char *json_string(const char *p, char *dst, size_t cap) {
+  size_t n = 0;
+  for (; *p && *p != '"'; p++) {
+    if (*p == '\\' && p[1]) {
+      p++;
+    }
+    if (n + 1 < cap) {
+      dst[n++] = *p;
+    }
+  }
+  dst[n] = '\0';
+  return *p ? p + 1 : p;
+}
+
+/* Numbers separated by commas or spaces, up to `stop` */
+static int parse_samples(const char *p, char stop, double *out) {
+  int n = 0;
+  while (*p && *p != stop && *p != '\n' && n < MAX_RUNS) {
+    char *end;
+    double v = strtod(p, &end);
+    if (end == p) {
+      p++;
+      continue;
+    }
+    out[n++] = v;
+    p = end;
+  }
+  return n;
+}
+
+/* The layout benchmark.c writes: "git_sha", then per case "name" ... "samples" */
+static int parse_json(const char *data, struct result_file *rf) {
+  const char *p = strstr(data, "\"git_sha\"");
+  if (p && (p = strchr(p + 9, '"'))) {
+    json_string(p + 1, rf->sha, sizeof(rf->sha));
+  }
+  p = data;
+  while (rf->ncases < MAX_CASES && (p = strstr(p, "\"name\"")) != NULL) {
+    struct bench_case *c = &rf->cases[rf->ncases];
+    const char *s;
+    if (!(p = strchr(p + 6, '"'))) {
+      break;
+    }
+    p = json_string(p + 1, c->name, sizeof(c->name));
+    if (!(s = strstr(p, "\"samples\"")) || !(s = strchr(s, '['))) {
+      break;
+    }
+    c->n = parse_samples(s + 1, ']', c->samples);
+    rf->ncases++;
+    p = s;
+  }
+  return rf->ncases > 0 ? 0 : -1;
+}
+
+/* Header line, then "case",...,git_sha,samples per line */
+static int parse_csv(const char *data, struct result_file *rf) {
+  const char *line = strchr(data, '\n');
+  while (line && *++line && rf->ncases < MAX_CASES) {
+    struct bench_case *c = &rf->cases[rf->ncases];
+    const char *eol = strchr(line, '\n');
+    const char *last = NULL, *sha = NULL, *q;
+    if (*line != '"') {
+      break;
+    }
+    json_string(line + 1, c->name, sizeof(c->name));
+    for (q = line; *q && *q != '\n'; q++) {
+      if (*q == ',') {
+        sha = last;
+        last = q;
+      }
+    }
+    if (!last) {
+      break;
+    }
+    if (!rf->sha[0] && sha && last - sha - 1 < (long)sizeof(rf->sha)) {
+      memcpy(rf->sha, sha + 1, (size_t)(last - sha - 1));
+      rf->sha[last - sha - 1] = '\0';
+    }
+    c->n = parse_samples(last + 1, '\n', c->samples);
+    rf->ncases++;
+    line = eol;
+  }
+  return rf->ncases > 0 ? 0 : -1;
+}
+
+static int load_results(const char *path, struct result_file *rf) {
+  char *data = read_file(path);
+  const char *p;
+  int rv;
+
+  if (!data) {
+    return -1;
+  }
+  memset(rf, 0, sizeof(*rf));
+  for (p = data; isspace((unsigned char)*p); p++) {
+  }
+  rv = *p == '{' ? parse_json(p, rf) : parse_csv(p, rf);
+  if (rv != 0) {
+    fprintf(stderr, "%s: no benchmark cases found\n", path);
+  }
+  free(data);
+  return rv;
+}
+
+/* ============================================================================
+ * STATISTICS
+ * ============================================================================ */
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double median(const double *v, int n) {
+  double tmp[MAX_RUNS];
+  memcpy(tmp, v, (size_t)n * sizeof(*v));
+  qsort(tmp, (size_t)n, sizeof(*tmp), cmp_double);
+  return n % 2 ? tmp[n / 2] : (tmp[n / 2 - 1] + tmp[n / 2]) / 2;
+}
+
+/* P(U <= u) for sample sizes m and n without ties: count the orderings
+ * with each U, c(m, n, u) = c(m - 1, n, u - n) + c(m, n - 1, u) */
+static double exact_cdf(int m, int n, double u) {
+  int umax = m * n, i, j, k;
+  double *c = calloc((size_t)(m + 1) * (n + 1) * (umax + 1), sizeof(double));
+  double below = 0, total = 0;
+#define C(i, j, k) c[((size_t)(i) * (n + 1) + (j)) * (umax + 1) + (k)]
+
+  if (!c) {
+    return 1;
+  }
+  for (i = 0; i <= m; i++) {
+    for (j = 0; j <= n; j++) {
+      if (i == 0 || j == 0) {
+        C(i, j, 0) = 1;
+        continue;
+      }
+      for (k = 0; k <= i * j; k++) {
+        C(i, j, k) = (k >= j ? C(i - 1, j, k - j) : 0) + C(i, j - 1, k);
+      }
+    }
+  }
+  for (k = 0; k <= umax; k++) {
+    total += C(m, n, k);
+    if (k <= u) {
+      below += C(m, n, k);
+    }
+  }
+#undef C
+  free(c);
+  return below / total;
+}
+
+/* Two-sided Mann-Whitney U test of a against b */
+static double mann_whitney(const double *a, int m, const double *b, int n) {
+  struct {
+    double v;
+    int from_a;
+  } all[2 * MAX_RUNS], t;
+  double rank_a = 0, ties = 0, u, mu, sigma, z;
+  int total = m + n, i, j, tied = 0;
+
+  for (i = 0; i < m; i++) {
+    all[i].v = a[i];
+    all[i].from_a = 1;
+  }
+  for (i = 0; i < n; i++) {
+    all[m + i].v = b[i];
+    all[m + i].from_a = 0;
+  }
+  for (i = 1; i < total; i++) {
+    for (j = i; j > 0 && all[j - 1].v > all[j].v; j--) {
+      t = all[j];
+      all[j] = all[j - 1];
+      all[j - 1] = t;
+    }
+  }
+  /* Average ranks over runs of equal values */
+  for (i = 0; i < total; i = j) {
+    double avg;
+    for (j = i + 1; j < total && all[j].v == all[i].v; j++) {
+    }
+    avg = (i + 1 + j) / 2.0;
+    if (j - i > 1) {
+      tied = 1;
+      ties += (double)(j - i) * (j - i) * (j - i) - (j - i);
+    }
+    for (int k = i; k < j; k++) {
+      if (all[k].from_a) {
+        rank_a += avg;
+      }
+    }
+  }
+  u = rank_a - m * (m + 1) / 2.0;
+  u = u < m * n - u ? u : m * n - u;
+
+  if (!tied && m <= EXACT_MAX && n <= EXACT_MAX) {
+    double p = 2 * exact_cdf(m, n, u);
+    return p < 1 ? p : 1;
+  }
+  mu = m * n / 2.0;
+  sigma = sqrt(m * n / 12.0 * ((total + 1) - ties / ((double)total * (total - 1))));
+  if (sigma == 0) {
+    return 1;
+  }
+  z = (mu - u - 0.5) / sigma;
+  return z > 0 ? erfc(z / sqrt(2.0)) : 1;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv) {
+  static struct result_file base, cand;
+  double alpha = 0.01, threshold = 2.0;
+  int opt, bad = 0, regressions = 0, improvements = 0, few_runs = 0;
+
+  while ((opt = getopt(argc, argv, "a:t:")) != -1) {
+    switch (opt) {
+    case 'a': alpha = atof(optarg); break;
+    case 't': threshold = atof(optarg); break;
+    default: bad = 1; break;
+    }
+  }
+  if (bad || argc - optind != 2) {
+    fprintf(stderr, "usage: %s [-a alpha] [-t threshold%%] base.json new.json\n", argv[0]);
+    return 2;
+  }
+  if (load_results(argv[optind], &base) != 0 || load_results(argv[optind + 1], &cand) != 0) {
+    return 2;
+  }
+
+  printf("base %s (%s), new %s (%s)\n", argv[optind], base.sha[0] ? base.sha : "?",
+         argv[optind + 1], cand.sha[0] ? cand.sha : "?");
+  printf("Mann-Whitney U, two-sided, alpha %g; flagged if the median moves more than %g%%\n\n",
+         alpha, threshold);
+  printf("%-52s %10s %10s %8s %9s\n", "Case", "Base ns", "New ns", "Change", "p");
+
+  for (int i = 0; i < cand.ncases; i++) {
+    const struct bench_case *c = &cand.cases[i], *b = NULL;
+    double mb, mc, change, p;
+    const char *verdict = "";
+
+    for (int k = 0; k < base.ncases; k++) {
+      if (strcmp(base.cases[k].name, c->name) == 0) {
+        b = &base.cases[k];
+      }
+    }
+    if (!b || b->n == 0 || c->n == 0) {
+      printf("%-52.52s %10s\n", c->name, "(new)");
+      continue;
+    }
+    mb = median(b->samples, b->n);
+    mc = median(c->samples, c->n);
+    change = 100.0 * (mc - mb) / mb;
+    p = mann_whitney(b->samples, b->n, c->samples, c->n);
+    few_runs |= b->n < 5 || c->n < 5;
+    if (p < alpha && change > threshold) {
+      verdict = "  REGRESSION";
+      regressions++;
+    } else if (p < alpha && change < -threshold) {
+      verdict = "  faster";
+      improvements++;
+    }
+    printf("%-52.52s %10.3f %10.3f %+7.1f%% %9.4f%s\n", c->name, mb, mc, change, p, verdict);
+  }
+  for (int k = 0; k < base.ncases; k++) {
+    int found = 0;
+    for (int i = 0; i < cand.ncases; i++) {
+      found |= strcmp(base.cases[k].name, cand.cases[i].name) == 0;
+    }
+    if (!found) {
+      printf("%-52.52s %10s\n", base.cases[k].name, "(removed)");
+    }
+  }
+
+  printf("\n%d regression(s), %d improvement(s)\n", regressions, improvements);
+  if (few_runs) {
+    printf("Note: fewer than 5 runs on a side cannot reach p < 0.01; use --runs=10\n");
+  }
+  return regressions ? 1 : 0;
+}
@@ -0,0 +1,270 @@
+/* Synthetic URL corpus generator for bench_corpus
+ *
+ * Writes newline-separated request targets drawn from a fixed mix of
+ * shapes: origin-form paths, absolute URLs over several schemes, IPv4 and
+ * IPv6 hosts (some with zone IDs), userinfo, ports, long queries and
+ * fragments, plus a share of invalid URLs. The output depends only on the
+ * options, so a corpus can be regenerated anywhere instead of being
+ * checked in.
+ *
+ * Usage: gen_corpus [-n count] [-s seed] [-i invalid%] [-q long-query%]
+ *                   [-6 ipv6%] [-o file]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_URL 8192
+
+static uint64_t rng_state;
+
+/* splitmix64: small, fast and the same on every platform */
+static uint64_t next_rand(void) {
+  uint64_t z = (rng_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static unsigned int below(unsigned int n) {
+  return (unsigned int)(next_rand() % n);
+}
+
+static int percent(unsigned int p) {
+  return below(100) < p;
+}
+
+static const char *schemes[] = { "http", "https", "https", "https", "ws", "wss", "ftp" };
+static const char *words[] = {
+  "api", "v1", "v2", "users", "orders", "items", "static", "img", "js", "css",
+  "search", "login", "profile", "settings", "cart", "checkout", "health", "metrics",
+  "docs", "assets", "cdn", "media", "feed", "events", "reports", "export"
+};
+static const char *tlds[] = { "com", "net", "org", "io", "example", "co.uk" };
+static const char *keys[] = {
+  "q", "page", "limit", "sort", "order", "fields", "utm_source", "utm_medium",
+  "session", "token", "lang", "filter", "id", "ts", "callback"
+};
+
+#define PICK(a) (a[below(sizeof(a) / sizeof(a[0]))])
+
+struct out {
+  char buf[MAX_URL];
+  size_t len;
+};
+
+static void put(struct out *o, const char *s) {
+  size_t n = strlen(s);
+  if (o->len + n < MAX_URL) {
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+  }
+}
+
+static void putf_uint(struct out *o, unsigned int v) {
+  char tmp[16];
+  snprintf(tmp, sizeof(tmp), "%u", v);
+  put(o, tmp);
+}
+
+static void put_hex(struct out *o, unsigned int v) {
+  char tmp[16];
+  snprintf(tmp, sizeof(tmp), "%x", v);
+  put(o, tmp);
+}
+
+/* Unreserved characters, with the odd percent-escape */
+static void put_token(struct out *o, unsigned int min, unsigned int max) {
+  static const char alnum[] = "abcdefghijklmnopqrstuvwxyz0123456789-_.~";
+  unsigned int n = min + below(max - min + 1);
+  for (unsigned int k = 0; k < n && o->len + 3 < MAX_URL; k++) {
+    if (below(40) == 0) {
+      put(o, below(2) ? "%20" : "%C3%A9");
+    } else {
+      o->buf[o->len++] = alnum[below(sizeof(alnum) - 1)];
+    }
+  }
+}
+
+static void put_host(struct out *o, unsigned int ipv6_pct) {
+  if (percent(ipv6_pct)) {
+    put(o, "[");
+    if (below(3) == 0) {
+      put(o, "::1");
+    } else {
+      put(o, "2001:db8:");
+      put_hex(o, below(0x10000));
+      put(o, "::");
+      put_hex(o, below(0x10000));
+    }
+    if (below(10) == 0) {
+      put(o, "%25eth0");
+    }
+    put(o, "]");
+  } else if (below(10) == 0) {
+    putf_uint(o, 10 + below(240));
+    for (int k = 0; k < 3; k++) {
+      put(o, ".");
+      putf_uint(o, below(256));
+    }
+  } else {
+    if (below(2)) {
+      put(o, PICK(words));
+      put(o, ".");
+    }
+    put(o, PICK(words));
+    putf_uint(o, below(100));
+    put(o, ".");
+    put(o, PICK(tlds));
+  }
+}
+
+static void put_path(struct out *o) {
+  unsigned int segs = below(7);
+  if (segs == 0) {
+    put(o, "/");
+    return;
+  }
+  for (unsigned int k = 0; k < segs; k++) {
+    put(o, "/");
+    if (below(3) == 0) {
+      putf_uint(o, below(1000000));
+    } else {
+      put(o, PICK(words));
+    }
+  }
+  if (below(5) == 0) {
+    put(o, below(2) ? ".html" : ".json");
+  }
+}
+
+static void put_query(struct out *o, int long_query) {
+  unsigned int pairs = long_query ? 40 + below(200) : 1 + below(5);
+  put(o, "?");
+  for (unsigned int k = 0; k < pairs; k++) {
+    if (k > 0) {
+      put(o, "&");
+    }
+    put(o, PICK(keys));
+    put(o, "=");
+    put_token(o, 1, long_query ? 40 : 12);
+  }
+}
+
+/* Break a valid URL in one of the ways real traffic does */
+static void corrupt(struct out *o) {
+  size_t at = o->len > 1 ? 1 + below((unsigned int)(o->len - 1)) : 0;
+  switch (below(5)) {
+  case 0: /* raw space */
+    if (at < o->len) {
+      o->buf[at] = ' ';
+    }
+    break;
+  case 1: /* control byte */
+    if (at < o->len) {
+      o->buf[at] = (char)(1 + below(31));
+      if (o->buf[at] == '\n' || o->buf[at] == '\r') {
+        o->buf[at] = '\t';
+      }
+    }
+    break;
+  case 2: /* bad port */
+    o->len = 0;
+    put(o, "http://example.com:");
+    putf_uint(o, 65536 + below(100000));
+    put(o, "/x");
+    break;
+  case 3: /* unclosed IPv6 literal */
+    o->len = 0;
+    put(o, "http://[2001:db8::");
+    put_hex(o, below(0x10000));
+    put(o, "/path");
+    break;
+  default: /* bad escape in the host */
+    o->len = 0;
+    put(o, "https://%zz");
+    put(o, PICK(words));
+    put(o, ".com/");
+    break;
+  }
+}
+
+static void gen_url(struct out *o, unsigned int invalid_pct, unsigned int long_pct,
+                    unsigned int ipv6_pct) {
+  int long_query = percent(long_pct);
+  o->len = 0;
+
+  if (below(10) < 4) {
+    /* Origin form, as in a request line */
+    put_path(o);
+  } else {
+    put(o, PICK(schemes));
+    put(o, "://");
+    if (below(20) == 0) {
+      put_token(o, 3, 8);
+      put(o, ":");
+      put_token(o, 4, 12);
+      put(o, "@");
+    }
+    put_host(o, ipv6_pct);
+    if (below(4) == 0) {
+      put(o, ":");
+      putf_uint(o, 1 + below(65535));
+    }
+    put_path(o);
+  }
+  if (long_query || below(2)) {
+    put_query(o, long_query);
+  }
+  if (below(10) == 0) {
+    put(o, "#");
+    put_token(o, 1, 10);
+  }
+  if (percent(invalid_pct)) {
+    corrupt(o);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned long count = 1000000;
+  unsigned int invalid_pct = 2, long_pct = 5, ipv6_pct = 5;
+  const char *path = NULL;
+  FILE *f = stdout;
+  struct out o;
+  int opt;
+
+  rng_state = 1;
+  while ((opt = getopt(argc, argv, "n:s:i:q:6:o:")) != -1) {
+    switch (opt) {
+    case 'n': count = strtoul(optarg, NULL, 10); break;
+    case 's': rng_state = strtoull(optarg, NULL, 10); break;
+    case 'i': invalid_pct = (unsigned int)atoi(optarg); break;
+    case 'q': long_pct = (unsigned int)atoi(optarg); break;
+    case '6': ipv6_pct = (unsigned int)atoi(optarg); break;
+    case 'o': path = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-n count] [-s seed] [-i invalid%%] [-q long-query%%] "
+                      "[-6 ipv6%%] [-o file]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (path && !(f = fopen(path, "w"))) {
+    perror(path);
+    return 1;
+  }
+
+  for (unsigned long n = 0; n < count; n++) {
+    gen_url(&o, invalid_pct, long_pct, ipv6_pct);
+    o.buf[o.len++] = '\n';
+    fwrite(o.buf, 1, o.len, f);
+  }
+
+  if (path && fclose(f) != 0) {
+    perror(path);
+    return 1;
+  }
+  return 0;
+}
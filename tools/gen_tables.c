@@ -0,0 +1,782 @@
+/* Table generator for llurl.c
+ *
+ * Reads tools/url_tables.spec (named byte sets, character flags, the bytes
+ * valid anywhere in a URL and, for the table-driven states, which bytes
+ * lead where) and writes llurl_tables.h:
+ *
+ *   CHAR_* / char_flags[256]
+ *                          one bit per `flag` line; byte c has the bit
+ *                          when it is in the flag's set
+ *   url_class_table[256]   byte -> equivalence class. Two bytes share a
+ *                          class when they agree on `valid` and every
+ *                          state sends them to the same place, so there
+ *                          are as many classes as distinct columns,
+ *                          however the spec names its sets. Class 0 is
+ *                          the bytes outside `valid`; the parser only
+ *                          tests for class 0, in its invalid-byte scan.
+ *   url_next_<state>[256]  for states marked hot: byte -> next state in
+ *                          one load
+ *   url_tables[]           char_flags and the hot tables per table set,
+ *                          for the parser to pick
+ *
+ * Only states the parser reads a table for have rules, and a rule may only
+ * take bytes in `valid`. States coded by hand in llurl.c are declared only
+ * where a rule names them as its target.
+ *
+ * The spec outside any `profile` section gives the default table set, with
+ * the names above. Each profile section may redefine sets and flags and add
+ * rules, and gets a table set of its own whose names end in _<profile>.
+ * Sets are looked up by name when a table set is built, so redefining one
+ * in a profile changes every set, flag and rule that refers to it.
+ *
+ * The header is committed; `make tables` regenerates it and `make test`
+ * checks that it is current.
+ *
+ * Usage: gen_tables [-o file] spec
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_DEFS 128
+#define MAX_RULES 256
+#define MAX_STATES 32
+#define MAX_PROFILES 8
+#define MAX_FLAGS 8
+#define MAX_NAME 48
+#define MAX_LINE 512
+#define MAX_DEPTH 32
+#define STAY_VALUE 0xFF
+#define BASE (-1)
+
+/* A set or flag definition. Its items are kept as text and read again
+ * for every table set, which is what lets a profile redefine a set. */
+struct def {
+  char name[MAX_NAME];
+  int profile;
+  int line;
+  char items[MAX_LINE];
+};
+
+struct rule {
+  int profile;
+  int state;
+  int line;
+  int target; /* state index or STAY_VALUE */
+  char items[MAX_LINE];
+};
+
+struct flag {
+  char name[MAX_NAME];
+  char comment[MAX_LINE];
+};
+
+struct state_def {
+  char name[MAX_NAME];
+  int hot;
+};
+
+/* Everything generated for one table set */
+struct table_set {
+  const char *suffix; /* "" or "_<profile>" */
+  unsigned char next[MAX_STATES][256];
+  unsigned char flags[256];
+  unsigned char valid[256];
+  unsigned char byte_class[256];
+  unsigned char class_rep[256]; /* one byte of each class */
+  int nclasses;
+};
+
+static struct def sets[MAX_DEFS];
+static int nsets;
+static struct def flag_defs[MAX_DEFS];
+static int nflag_defs;
+static struct def valid_defs[MAX_DEFS];
+static int nvalid_defs;
+static struct flag flags[MAX_FLAGS];
+static int nflags;
+static struct rule rules[MAX_RULES];
+static int nrules;
+static struct state_def states[MAX_STATES];
+static int nstates;
+static char profiles[MAX_PROFILES][MAX_NAME];
+static char suffixes[MAX_PROFILES][MAX_NAME + 1];
+static int nprofiles;
+static struct table_set tsets[MAX_PROFILES + 1];
+
+static const char *spec_path;
+static int lineno;
+
+static void fail(const char *msg, const char *arg) {
+  fprintf(stderr, "%s:%d: %s%s%s\n", spec_path, lineno, msg, arg ? ": " : "", arg ? arg : "");
+  exit(1);
+}
+
+/* ============================================================================
+ * READING THE SPEC
+ * ============================================================================ */
+
+/* Next whitespace-separated token; a quoted string is one token */
+static char *next_token(char **pos) {
+  char *p = *pos, *start;
+
+  while (*p && isspace((unsigned char)*p)) {
+    p++;
+  }
+  if (!*p || *p == '#') {
+    *pos = p;
+    return NULL;
+  }
+  start = p;
+  if (*p == '"') {
+    for (p++; *p && *p != '"'; p++) {
+    }
+    if (*p != '"') {
+      fail("unterminated string", start);
+    }
+    p++;
+  } else {
+    while (*p && !isspace((unsigned char)*p)) {
+      p++;
+    }
+  }
+  if (*p) {
+    *p++ = '\0';
+  }
+  *pos = p;
+  return start;
+}
+
+/* The rest of the line up to a comment, for re-reading later */
+static void rest_of_line(char *pos, char *dst) {
+  char *p = pos;
+  size_t n;
+
+  for (int quoted = 0; *p && (quoted || *p != '#'); p++) {
+    quoted ^= *p == '"';
+  }
+  n = (size_t)(p - pos);
+  if (n >= MAX_LINE) {
+    fail("line too long", NULL);
+  }
+  memcpy(dst, pos, n);
+  dst[n] = '\0';
+}
+
+/* Text of a trailing "# comment", trimmed */
+static void trailing_comment(const char *line, char *dst) {
+  const char *p = line, *end;
+  int quoted = 0;
+
+  for (; *p && (quoted || *p != '#'); p++) {
+    quoted ^= *p == '"';
+  }
+  dst[0] = '\0';
+  if (!*p) {
+    return;
+  }
+  for (p++; isspace((unsigned char)*p); p++) {
+  }
+  for (end = p + strlen(p); end > p && isspace((unsigned char)end[-1]); end--) {
+  }
+  if (end - p >= MAX_LINE) {
+    fail("comment too long", NULL);
+  }
+  memcpy(dst, p, (size_t)(end - p));
+  dst[end - p] = '\0';
+}
+
+static void copy_name(char *dst, const char *src) {
+  if (strlen(src) >= MAX_NAME) {
+    fail("name too long", src);
+  }
+  strcpy(dst, src);
+}
+
+static int find_state(const char *name) {
+  for (int k = 0; k < nstates; k++) {
+    if (strcmp(states[k].name, name) == 0) {
+      return k;
+    }
+  }
+  return -1;
+}
+
+static int find_profile(const char *name) {
+  for (int k = 0; k < nprofiles; k++) {
+    if (strcmp(profiles[k], name) == 0) {
+      return k;
+    }
+  }
+  return -1;
+}
+
+/* The definition of `name` a table set sees: its profile's, else the base */
+static const struct def *find_def(const struct def *defs, int n, const char *name, int profile) {
+  const struct def *base = NULL;
+  for (int k = 0; k < n; k++) {
+    if (strcmp(defs[k].name, name) == 0) {
+      if (defs[k].profile == profile) {
+        return &defs[k];
+      }
+      if (defs[k].profile == BASE) {
+        base = &defs[k];
+      }
+    }
+  }
+  return base;
+}
+
+static void add_def(struct def *defs, int *n, const char *name, int profile, char *pos) {
+  if (*n == MAX_DEFS) {
+    fail("too many definitions", name);
+  }
+  for (int k = 0; k < *n; k++) {
+    if (strcmp(defs[k].name, name) == 0 && defs[k].profile == profile) {
+      fail("defined twice", name);
+    }
+  }
+  copy_name(defs[*n].name, name);
+  defs[*n].profile = profile;
+  defs[*n].line = lineno;
+  rest_of_line(pos, defs[*n].items);
+  (*n)++;
+}
+
+/* First pass: state names only, so rules may name states defined later */
+static void read_state_names(FILE *f) {
+  char line[MAX_LINE];
+  int in_profile = 0;
+
+  lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char *pos = line, *tok;
+    lineno++;
+    if (!(tok = next_token(&pos))) {
+      continue;
+    }
+    if (strcmp(tok, "profile") == 0) {
+      in_profile = 1;
+    }
+    if (strcmp(tok, "state") != 0 || in_profile) {
+      continue;
+    }
+    if (!(tok = next_token(&pos))) {
+      fail("state without a name", NULL);
+    }
+    if (nstates == MAX_STATES || find_state(tok) >= 0) {
+      fail("too many states, or a duplicate", tok);
+    }
+    copy_name(states[nstates].name, tok);
+    if ((tok = next_token(&pos))) {
+      if (strcmp(tok, "hot") != 0) {
+        fail("expected 'hot'", tok);
+      }
+      states[nstates].hot = 1;
+    }
+    nstates++;
+  }
+  if (nstates == 0 || strcmp(states[0].name, "s_dead") != 0) {
+    fail("the first state must be s_dead", NULL);
+  }
+}
+
+/* Second pass: profiles, sets, flags and rules */
+static void read_spec(FILE *f) {
+  char line[MAX_LINE];
+  int profile = BASE, state = -1;
+
+  lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char whole[MAX_LINE];
+    char *pos = line, *tok;
+
+    lineno++;
+    strcpy(whole, line);
+    if (!(tok = next_token(&pos))) {
+      continue;
+    }
+
+    if (strcmp(tok, "profile") == 0) {
+      if (!(tok = next_token(&pos)) || next_token(&pos)) {
+        fail("expected 'profile NAME'", NULL);
+      }
+      if (nprofiles == MAX_PROFILES || find_profile(tok) >= 0) {
+        fail("too many profiles, or a duplicate", tok);
+      }
+      copy_name(profiles[nprofiles], tok);
+      profile = nprofiles++;
+      state = -1;
+
+    } else if (strcmp(tok, "set") == 0 || strcmp(tok, "flag") == 0) {
+      int is_flag = tok[0] == 'f';
+      if (!(tok = next_token(&pos))) {
+        fail("definition without a name", NULL);
+      }
+      if (is_flag) {
+        int k;
+        for (k = 0; k < nflags && strcmp(flags[k].name, tok) != 0; k++) {
+        }
+        if (k == nflags) {
+          if (profile != BASE) {
+            fail("a profile may only redefine flags", tok);
+          }
+          if (nflags == MAX_FLAGS) {
+            fail("more flags than bits in a byte", tok);
+          }
+          copy_name(flags[nflags].name, tok);
+          trailing_comment(whole, flags[nflags].comment);
+          nflags++;
+        }
+        add_def(flag_defs, &nflag_defs, tok, profile, pos);
+      } else {
+        add_def(sets, &nsets, tok, profile, pos);
+      }
+      state = -1;
+
+    } else if (strcmp(tok, "valid") == 0) {
+      add_def(valid_defs, &nvalid_defs, "valid", profile, pos);
+      state = -1;
+
+    } else if (strcmp(tok, "state") == 0) {
+      if (!(tok = next_token(&pos)) || (state = find_state(tok)) < 0) {
+        fail("unknown state", tok);
+      }
+      if (profile != BASE && next_token(&pos)) {
+        fail("a profile cannot change which states are hot", NULL);
+      }
+
+    } else {
+      /* ITEM... -> NEXT; the items are checked when a table set is built */
+      struct rule *r = &rules[nrules];
+      char *arrow = strstr(whole, "->");
+      if (state < 0) {
+        fail("rule outside a state", tok);
+      }
+      if (nrules == MAX_RULES) {
+        fail("too many rules", NULL);
+      }
+      if (!arrow) {
+        fail("rule without '-> NEXT'", NULL);
+      }
+      *arrow = '\0';
+      pos = arrow + 2;
+      if (!(tok = next_token(&pos)) || next_token(&pos)) {
+        fail("expected one state after '->'", NULL);
+      }
+      if (strcmp(tok, "STAY") == 0) {
+        r->target = STAY_VALUE;
+      } else if ((r->target = find_state(tok)) < 0) {
+        fail("unknown state", tok);
+      }
+      r->profile = profile;
+      r->state = state;
+      r->line = lineno;
+      rest_of_line(whole, r->items);
+      nrules++;
+    }
+  }
+}
+
+/* ============================================================================
+ * BUILDING A TABLE SET
+ * ============================================================================ */
+
+static int hex_digit(int c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = tolower(c);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static void eval_items(const char *text, int profile, unsigned char *has, int depth);
+
+/* Add the bytes one item names to `has` */
+static void add_item(const char *item, int profile, unsigned char *has, int depth) {
+  size_t len = strlen(item);
+  const struct def *d;
+
+  if (item[0] == '"') {
+    for (const char *p = item + 1; *p != '"'; p++) {
+      has[(unsigned char)*p] = 1;
+    }
+  } else if (len == 4 && item[0] == '\\' && item[1] == 'x' && hex_digit(item[2]) >= 0 &&
+             hex_digit(item[3]) >= 0) {
+    has[hex_digit(item[2]) * 16 + hex_digit(item[3])] = 1;
+  } else if (len == 3 && item[1] == '-') {
+    if ((unsigned char)item[0] > (unsigned char)item[2]) {
+      fail("empty range", item);
+    }
+    for (int c = (unsigned char)item[0]; c <= (unsigned char)item[2]; c++) {
+      has[c] = 1;
+    }
+  } else if (len == 9 && item[0] == '\\' && item[1] == 'x' && item[4] == '-' &&
+             item[5] == '\\' && item[6] == 'x') {
+    int lo = hex_digit(item[2]) * 16 + hex_digit(item[3]);
+    int hi = hex_digit(item[7]) * 16 + hex_digit(item[8]);
+    if (hex_digit(item[2]) < 0 || hex_digit(item[3]) < 0 || hex_digit(item[7]) < 0 ||
+        hex_digit(item[8]) < 0 || lo > hi) {
+      fail("bad byte range", item);
+    }
+    for (int c = lo; c <= hi; c++) {
+      has[c] = 1;
+    }
+  } else if ((d = find_def(sets, nsets, item, profile)) != NULL) {
+    int saved = lineno;
+    if (depth == MAX_DEPTH) {
+      fail("sets refer to each other in a loop", item);
+    }
+    lineno = d->line;
+    eval_items(d->items, profile, has, depth + 1);
+    lineno = saved;
+  } else {
+    fail("unknown set", item);
+  }
+}
+
+/* ITEM... [except ITEM...] */
+static void eval_items(const char *text, int profile, unsigned char *has, int depth) {
+  unsigned char add[256] = { 0 }, remove[256] = { 0 };
+  unsigned char *into = add;
+  char copy[MAX_LINE], *pos = copy, *tok;
+
+  strcpy(copy, text);
+  while ((tok = next_token(&pos))) {
+    if (strcmp(tok, "except") == 0) {
+      into = remove;
+    } else {
+      add_item(tok, profile, into, depth);
+    }
+  }
+  for (int c = 0; c < 256; c++) {
+    has[c] |= add[c] && !remove[c];
+  }
+}
+
+static int same_column(const struct table_set *t, int a, int b) {
+  if (t->valid[a] != t->valid[b]) {
+    return 0;
+  }
+  for (int s = 0; s < nstates; s++) {
+    if (t->next[s][a] != t->next[s][b]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Classes are numbered in order of first appearance, after class 0, the
+ * bytes outside `valid` */
+static void build_classes(struct table_set *t) {
+  int dead_byte = -1;
+
+  for (int c = 0; c < 256 && dead_byte < 0; c++) {
+    if (!t->valid[c]) {
+      dead_byte = c;
+    }
+  }
+  if (dead_byte < 0) {
+    fail("every byte is valid, so class 0 would be empty", t->suffix);
+  }
+  t->class_rep[0] = (unsigned char)dead_byte;
+  t->nclasses = 1;
+
+  for (int c = 0; c < 256; c++) {
+    int k;
+    for (k = 0; k < t->nclasses && !same_column(t, c, t->class_rep[k]); k++) {
+    }
+    if (k == t->nclasses) {
+      t->class_rep[t->nclasses++] = (unsigned char)c;
+    }
+    t->byte_class[c] = (unsigned char)k;
+  }
+}
+
+/* Base rules first, then the profile's, so a profile's rule wins */
+static void build_table_set(struct table_set *t, int profile) {
+  const struct def *v = find_def(valid_defs, nvalid_defs, "valid", profile);
+
+  memset(t->next, 0, sizeof(t->next));
+  memset(t->flags, 0, sizeof(t->flags));
+  memset(t->valid, 0, sizeof(t->valid));
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (int k = 0; k < nrules; k++) {
+      const struct rule *r = &rules[k];
+      unsigned char has[256] = { 0 };
+      if (r->profile != (pass == 0 ? BASE : profile) || (pass == 1 && profile == BASE)) {
+        continue;
+      }
+      lineno = r->line;
+      eval_items(r->items, profile, has, 0);
+      for (int c = 0; c < 256; c++) {
+        if (has[c]) {
+          t->next[r->state][c] = (unsigned char)r->target;
+        }
+      }
+    }
+  }
+
+  for (int f = 0; f < nflags; f++) {
+    const struct def *d = find_def(flag_defs, nflag_defs, flags[f].name, profile);
+    unsigned char has[256] = { 0 };
+    lineno = d->line;
+    eval_items(d->items, profile, has, 0);
+    for (int c = 0; c < 256; c++) {
+      if (has[c]) {
+        t->flags[c] |= (unsigned char)(1u << f);
+      }
+    }
+  }
+
+  if (!v) {
+    fail("no 'valid' line", NULL);
+  }
+  lineno = v->line;
+  eval_items(v->items, profile, t->valid, 0);
+  for (int s = 0; s < nstates; s++) {
+    for (int c = 0; c < 256; c++) {
+      if (t->next[s][c] != 0 && !t->valid[c]) {
+        fail("a rule of this state takes a byte outside 'valid'", states[s].name);
+      }
+    }
+  }
+
+  build_classes(t);
+}
+
+/* ============================================================================
+ * OUTPUT
+ * ============================================================================ */
+
+/* "0-9 A-Z a-z" style list of the printable bytes in a class, for comments */
+static void describe_class(const struct table_set *t, int k, char *buf, size_t cap) {
+  size_t n = 0;
+  int other = 0;
+
+  buf[0] = '\0';
+  for (int c = 0; c < 256; c++) {
+    int end = c;
+    if (t->byte_class[c] != k) {
+      continue;
+    }
+    if (c <= 0x20 || c >= 0x7F) {
+      other++;
+      continue;
+    }
+    while (end + 1 < 0x7F && t->byte_class[end + 1] == k) {
+      end++;
+    }
+    if (n + 16 < cap) {
+      n += (size_t)snprintf(buf + n, cap - n, end - c >= 2 ? "%s%c-%c" : "%s%c", n ? " " : "",
+                            c, end);
+      if (end - c == 1) {
+        n += (size_t)snprintf(buf + n, cap - n, " %c", end);
+      }
+    }
+    c = end;
+  }
+  if (other && n + 24 < cap) {
+    snprintf(buf + n, cap - n, "%s%d other bytes", n ? ", " : "", other);
+  }
+}
+
+static void print_value(FILE *out, int v) {
+  if (v == STAY_VALUE) {
+    fprintf(out, "STAY");
+  } else {
+    fprintf(out, "%s", states[v].name);
+  }
+}
+
+enum { AS_NUMBER, AS_HEX, AS_STATE };
+
+/* 256 entries, numbers 16 to a line or state names 8 to a line, with the
+ * printable bytes of each line alongside */
+static void print_byte_table(FILE *out, const unsigned char *v, int as) {
+  int per_line = as == AS_STATE ? 8 : 16;
+
+  for (int row = 0; row < 256; row += per_line) {
+    fprintf(out, "  ");
+    for (int c = row; c < row + per_line; c++) {
+      if (as == AS_STATE) {
+        print_value(out, v[c]);
+      } else {
+        fprintf(out, as == AS_HEX ? "0x%02x" : "%d", v[c]);
+      }
+      fprintf(out, c == 255 ? "" : ",");
+    }
+    if (row >= 0x20 && row < 0x80) {
+      fprintf(out, " /* ");
+      for (int c = row; c < row + per_line; c++) {
+        fputc(c == 0x7F ? '.' : c, out);
+      }
+      fprintf(out, " */");
+    }
+    fprintf(out, "\n");
+  }
+}
+
+static void write_table_set(FILE *out, const struct table_set *t, int profile) {
+  const char *sfx = t->suffix;
+  char desc[512];
+
+  if (profile != BASE) {
+    fprintf(out, "/* ----------------------------------------------------------------------------\n");
+    fprintf(out, " * Profile %s\n", profiles[profile]);
+    fprintf(out, " * ------------------------------------------------------------------------- */\n\n");
+  }
+
+  fprintf(out, "static const unsigned char char_flags%s[256] = {\n", sfx);
+  print_byte_table(out, t->flags, AS_HEX);
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "/* Byte equivalence classes; class 0 is the bytes outside `valid`\n");
+  for (int k = 0; k < t->nclasses; k++) {
+    describe_class(t, k, desc, sizeof(desc));
+    fprintf(out, " *   %2d  %s\n", k, desc);
+  }
+  fprintf(out, " */\n");
+
+  fprintf(out, "static const unsigned char url_class_table%s[256] = {\n", sfx);
+  print_byte_table(out, t->byte_class, AS_NUMBER);
+  fprintf(out, "};\n");
+
+  for (int s = 0; s < nstates; s++) {
+    if (!states[s].hot) {
+      continue;
+    }
+    fprintf(out, "\n/* %s: next state for each byte, s_dead on error */\n", states[s].name);
+    fprintf(out, "static const unsigned char url_next_%s%s[256] = {\n", states[s].name, sfx);
+    print_byte_table(out, t->next[s], AS_STATE);
+    fprintf(out, "};\n");
+  }
+  fprintf(out, "\n");
+}
+
+static void print_upper(FILE *out, const char *s) {
+  for (; *s; s++) {
+    fputc(toupper((unsigned char)*s), out);
+  }
+}
+
+static void write_header(FILE *out) {
+  int p, s;
+
+  fprintf(out, "/* Generated by tools/gen_tables from tools/url_tables.spec by `make tables`.\n");
+  fprintf(out, " * Do not edit; change the spec and regenerate. Included by llurl.c after\n");
+  fprintf(out, " * enum state and STAY are defined. */\n\n");
+  fprintf(out, "#ifndef LLURL_TABLES_H\n#define LLURL_TABLES_H\n\n");
+
+  fprintf(out, "/* char_flags[byte] bits */\n");
+  for (int f = 0; f < nflags; f++) {
+    fprintf(out, "#define %-16s 0x%02x", flags[f].name, 1u << f);
+    if (flags[f].comment[0]) {
+      fprintf(out, "  /* %s */", flags[f].comment);
+    }
+    fprintf(out, "\n");
+  }
+  fprintf(out, "\n");
+
+  for (p = BASE; p < nprofiles; p++) {
+    write_table_set(out, &tsets[p + 1], p);
+  }
+
+  fprintf(out, "/* Table sets: the default, then one per profile in the spec */\n");
+  fprintf(out, "enum url_table_set {\n  URL_TABLES_DEFAULT,\n");
+  for (p = 0; p < nprofiles; p++) {
+    fprintf(out, "  URL_TABLES_");
+    print_upper(out, profiles[p]);
+    fprintf(out, ",\n");
+  }
+  fprintf(out, "  URL_NUM_TABLE_SETS\n};\n\n");
+
+  fprintf(out, "struct url_tables {\n");
+  fprintf(out, "  const unsigned char *flags; /* char_flags */\n");
+  for (s = 0; s < nstates; s++) {
+    if (states[s].hot) {
+      fprintf(out, "  const unsigned char *next_%s;\n", states[s].name);
+    }
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "static const struct url_tables url_tables[URL_NUM_TABLE_SETS] = {\n");
+  for (p = BASE; p < nprofiles; p++) {
+    const char *sfx = tsets[p + 1].suffix;
+    fprintf(out, "  [URL_TABLES_");
+    print_upper(out, p == BASE ? "default" : profiles[p]);
+    fprintf(out, "] = { char_flags%s", sfx);
+    for (s = 0; s < nstates; s++) {
+      if (states[s].hot) {
+        fprintf(out, ", url_next_%s%s", states[s].name, sfx);
+      }
+    }
+    fprintf(out, " },\n");
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "/* X(set, suffix) for each table set, for static per-set data */\n");
+  fprintf(out, "#define URL_TABLE_SETS(X) \\\n");
+  for (p = BASE; p < nprofiles; p++) {
+    fprintf(out, "  X(URL_TABLES_");
+    print_upper(out, p == BASE ? "default" : profiles[p]);
+    fprintf(out, ", %s)%s\n", tsets[p + 1].suffix, p + 1 < nprofiles ? " \\" : "");
+  }
+  fprintf(out, "\n");
+
+  fprintf(out, "#endif /* LLURL_TABLES_H */\n");
+}
+
+int main(int argc, char **argv) {
+  const char *out_path = NULL;
+  FILE *f, *out = stdout;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "o:")) != -1) {
+    if (opt != 'o') {
+      fprintf(stderr, "usage: %s [-o file] spec\n", argv[0]);
+      return 2;
+    }
+    out_path = optarg;
+  }
+  if (argc - optind != 1) {
+    fprintf(stderr, "usage: %s [-o file] spec\n", argv[0]);
+    return 2;
+  }
+  spec_path = argv[optind];
+  if (!(f = fopen(spec_path, "r"))) {
+    perror(spec_path);
+    return 1;
+  }
+  read_state_names(f);
+  rewind(f);
+  read_spec(f);
+  fclose(f);
+
+  tsets[0].suffix = "";
+  build_table_set(&tsets[0], BASE);
+  for (int p = 0; p < nprofiles; p++) {
+    snprintf(suffixes[p], sizeof(suffixes[p]), "_%.47s", profiles[p]);
+    tsets[p + 1].suffix = suffixes[p];
+    build_table_set(&tsets[p + 1], p);
+  }
+
+  if (out_path && !(out = fopen(out_path, "w"))) {
+    perror(out_path);
+    return 1;
+  }
+  write_header(out);
+  if (out != stdout && fclose(out) != 0) {
+    perror(out_path);
+    return 1;
+  }
+  for (int p = BASE; p < nprofiles; p++) {
+    fprintf(stderr, "%s: %d states, %d byte classes\n",
+            p == BASE ? "default" : profiles[p], nstates, tsets[p + 1].nclasses);
+  }
+  return 0;
+}
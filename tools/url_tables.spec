@@ -0,0 +1,81 @@
+# URL parser tables, compiled by tools/gen_tables into llurl_tables.h
+#
+#   set NAME ITEM...        a named byte set
+#   flag NAME ITEM...       a char_flags bit, set for the bytes listed
+#   valid ITEM...           the bytes that may appear anywhere in a URL;
+#                           the rest are class 0 of url_class_table
+#   state NAME [hot]        start a state; bytes no rule matches go to s_dead
+#     ITEM... -> NEXT       NEXT is a state or STAY; later rules override
+#   profile NAME            start a profile section, see the end of the file
+#
+# An ITEM is a range (a-z or \x80-\xff), a quoted string of bytes ("/?#"),
+# a single byte as \xNN, or the name of a set. "except ITEM..." at the end
+# of a list removes bytes from it. States are the enum state names in
+# llurl.c. A hot state also gets a 256-entry next-state table indexed by
+# the byte itself, for a loop that consults the table on every byte.
+#
+# Everything outside a profile section makes the default table set.
+#
+# All of it drives the parser: the char_flags bits, `valid` (class
+# 0, the bytes the invalid-byte scan rejects) and the rules of the hot
+# state s_schema. The other states are coded by hand in llurl.c around the
+# vector scans and have no rules here; they are declared only as targets.
+
+set ALPHA       a-z A-Z
+set DIGIT       0-9
+set UNRESERVED  ALPHA DIGIT "-._~"
+set SUBDELIMS   "!$&'()*+,;="
+set HEXDIG      DIGIT a-f A-F
+set URLCHAR     UNRESERVED SUBDELIMS ":/?#[]@%{}|"
+
+# char_flags bits, in order from 0x01
+flag CHAR_ALPHA       ALPHA                                 # a-z, A-Z
+flag CHAR_DIGIT       DIGIT                                 # 0-9
+flag CHAR_HEX         HEXDIG                                # 0-9, a-f, A-F
+flag CHAR_UNRESERVED  "-._~"                                # - . _ ~
+flag CHAR_SUBDELIM    SUBDELIMS                             # ! $ & ' ( ) * + , ; =
+# '~' has never been in CHAR_USERINFO, so the host scan in s_server rejects
+# it after the first byte of the authority; kept that way for now
+flag CHAR_USERINFO    UNRESERVED SUBDELIMS ":%" except "~"  # Characters valid in userinfo
+flag CHAR_QUERY       URLCHAR except "&=#"                  # Valid in a query, except the & = # delimiters
+
+valid URLCHAR
+
+state s_dead
+
+state s_schema hot
+  ALPHA DIGIT "+-." -> STAY
+  ":"               -> s_schema_slash
+
+# After "scheme:" llurl.c expects "//" and goes on in code
+state s_schema_slash
+
+# Profiles. A profile section runs to the next profile line or the end of
+# the file. In it, set, flag and valid lines replace the default
+# definitions, and rules under a state line apply after the default ones.
+# Each profile gets a table set of its own, url_tables[URL_TABLES_<NAME>],
+# whose tables are named with a _<name> suffix.
+
+# RFC 3986 only: { } | are not URI characters, and '~' is unreserved in
+# the authority as everywhere else
+profile strict
+set URLCHAR           UNRESERVED SUBDELIMS ":/?#[]@%"
+flag CHAR_USERINFO    UNRESERVED SUBDELIMS ":%"
+
+# What browsers and clients put on the wire: space, " < > \ ^ ` and bytes
+# from 0x80 are taken as they are instead of failing the URL, and hosts may
+# hold raw non-ASCII (IDN) bytes. Control bytes and DEL still fail.
+profile lenient
+set URLCHAR           UNRESERVED SUBDELIMS ":/?#[]@%{}|" " <>^`" \x22 \x5c \x80-\xff
+flag CHAR_USERINFO    UNRESERVED SUBDELIMS ":%" \x80-\xff
+
+# UTF-8 mode (LLURL_PARSE_UTF8) parses a URL with non-ASCII bytes again
+# under these: the compat and strict sets plus the bytes from 0x80 in path,
+# query and fragment, but not in the authority. The parser then checks
+# that those bytes are well-formed UTF-8.
+profile utf8
+set URLCHAR           UNRESERVED SUBDELIMS ":/?#[]@%{}|" \x80-\xff
+
+profile strict_utf8
+set URLCHAR           UNRESERVED SUBDELIMS ":/?#[]@%" \x80-\xff
+flag CHAR_USERINFO    UNRESERVED SUBDELIMS ":%"